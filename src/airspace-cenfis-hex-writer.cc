@@ -31,6 +31,7 @@ public:
     CenfisHexAirspaceWriter(std::ostream *stream);
 public:
     virtual void write(const Airspace &airspace);
+    virtual void write_batch(const Airspace *buffer, size_t count);
     virtual void flush();
 };
 
@@ -51,6 +52,12 @@ void CenfisHexAirspaceWriter::write(const Airspace &airspace)
     asw->write(airspace);
 }
 
+void CenfisHexAirspaceWriter::write_batch(const Airspace *buffer,
+                                          size_t count)
+{
+    asw->write_batch(buffer, count);
+}
+
 void CenfisHexAirspaceWriter::flush()
 {
     asw->flush();
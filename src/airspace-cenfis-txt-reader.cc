@@ -26,13 +26,16 @@
 #include <stdlib.h>
 #include <string.h>
 
-class CenfisTextAirspaceReader : public AirspaceReader {
+class CenfisTextAirspaceReader : public AirspaceRecordReader {
 public:
     std::istream *stream;
+private:
+    /** see OpenAirAirspaceReader */
+    Airspace::EdgeList edges;
 public:
     CenfisTextAirspaceReader(std::istream *stream);
 public:
-    virtual const Airspace *read();
+    virtual bool read_into(Airspace &dest);
 };
 
 CenfisTextAirspaceReader::CenfisTextAirspaceReader(std::istream *_stream)
@@ -188,16 +191,17 @@ parse_arc(char *&src)
     return Edge(sign, end, center);
 }
 
-const Airspace *CenfisTextAirspaceReader::read() {
+bool CenfisTextAirspaceReader::read_into(Airspace &dest) {
     char line[512], *p;
     Airspace::type_t type = Airspace::TYPE_UNKNOWN;
     std::string cmd, name, name2, name3, name4, type_string;
     Altitude bottom(0, Altitude::UNIT_METERS, Altitude::REF_GND), top, top2;
-    Airspace::EdgeList edges;
     Frequency frequency;
     unsigned voice = 0;
     bool has_start = false;
 
+    edges.clear();
+
     while (!stream->eof()) {
         try {
             stream->getline(line, sizeof(line));
@@ -281,7 +285,7 @@ const Airspace *CenfisTextAirspaceReader::read() {
     }
 
     if (edges.size() == 0)
-        return NULL;
+        return false;
 
     if (name2.length() > 0 || name3.length() > 0 || name4.length() > 0 || type_string.length() > 0) {
         name += '|';
@@ -303,11 +307,12 @@ const Airspace *CenfisTextAirspaceReader::read() {
         name += type_string;
     }
 
-    return new Airspace(name, type,
-                        bottom, top, top2,
-                        edges,
-                        frequency,
-                        voice);
+    dest.assign(name, type,
+                bottom, top, top2,
+                edges,
+                frequency,
+                voice);
+    return true;
 }
 
 AirspaceReader *
@@ -323,9 +323,8 @@ CenfisAirspaceWriter::write(const Airspace &as)
     const SurfacePosition *firstVertex = has_first ? NULL : &buffer;
     size_t l_size_offset = 0;
 
-    for (Airspace::EdgeList::const_iterator it = edges.begin();
-         it != edges.end(); ++it) {
-        const Edge &edge = *it;
+    for (size_t i = 0; i < edges.size(); ++i) {
+        const Edge &edge = edges[i];
         if (firstVertex != NULL) {
             current.append(edge, *firstVertex);
         } else if (edge.getType() == Edge::TYPE_CIRCLE) {
@@ -20,24 +20,35 @@
 #include "airspace.hh"
 #include "airspace-io.hh"
 #include "exception.hh"
+#include "io-pipeline.hh"
 
 #include <fstream>
 #include <iostream>
+#include <vector>
 
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
 #include <getopt.h>
+#include <unistd.h>
 
 using std::cout;
 using std::cerr;
 using std::endl;
 
+/** the number of airspaces transferred with one read_batch() call */
+static const size_t BATCH_SIZE = 64;
+
+/** the number of batches in the ring between the reader and the
+    writer thread, see option -p */
+static const size_t RING_SIZE = 8;
+
 static void usage(const char *argv0) {
     cout << "usage: " << argv0 << " [options] FILE1 ...\n"
         "options:\n"
         " -o outfile   write output to this file\n"
         " -f outformat write output to stdout with this format\n"
+        " -p           read and write in separate threads\n"
         " -h           help (this text)\n";
 }
 
@@ -76,12 +87,15 @@ int main(int argc, char **argv) {
     const AirspaceFormat *out_format;
     std::ostream *out;
     AirspaceWriter *writer;
+    PipelineWriter<Airspace> *pipeline = NULL;
+    bool pipelined = false;
+    std::vector<Airspace> buffer(BATCH_SIZE);
 
     /* parse command line arguments */
     while (1) {
         int c;
 
-        c = getopt(argc, argv, "ho:f:");
+        c = getopt(argc, argv, "ho:f:p");
         if (c == -1)
             break;
 
@@ -100,6 +114,10 @@ int main(int argc, char **argv) {
             out_filename = NULL;
             break;
 
+        case 'p':
+            pipelined = true;
+            break;
+
         case '?':
             arg_error(argv[0], NULL);
 
@@ -145,6 +163,22 @@ int main(int argc, char **argv) {
         exit(1);
     }
 
+    /* with -p, the writer runs in its own thread, and the reader
+       parses directly into its ring buffer */
+
+    if (pipelined) {
+        try {
+            pipeline = new PipelineWriter<Airspace>(writer, BATCH_SIZE,
+                                                    RING_SIZE);
+        } catch (const std::exception &e) {
+            unlink(out_filename);
+            cerr << e.what() << endl;
+            exit(2);
+        }
+
+        writer = pipeline;
+    }
+
     /* read all input files */
 
     while (optind < argc) {
@@ -168,11 +202,15 @@ int main(int argc, char **argv) {
 
         /* transfer data */
         try {
-            const Airspace *as;
-
-            while ((as = reader->read()) != NULL) {
-                writer->write(*as);
-                delete as;
+            size_t n;
+
+            if (pipeline != NULL) {
+                while ((n = reader->read_batch(pipeline->begin_batch(),
+                                               BATCH_SIZE)) > 0)
+                    pipeline->commit_batch(n);
+            } else {
+                while ((n = reader->read_batch(&buffer[0], buffer.size())) > 0)
+                    writer->write_batch(&buffer[0], n);
             }
         } catch (const malformed_input &e) {
             delete writer;
@@ -193,7 +231,15 @@ int main(int argc, char **argv) {
         delete reader;
     }
 
-    writer->flush();
+    try {
+        writer->flush();
+    } catch (const std::exception &e) {
+        delete writer;
+        unlink(out_filename);
+        cerr << e.what() << endl;
+        exit(2);
+    }
+
     delete writer;
 
     if (out == &cout)
@@ -0,0 +1,366 @@
+/*
+ * loggertools
+ * Copyright (C) 2004-2008 Max Kellermann <max@duempel.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; version 2 of the License
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include "airspace-index.hh"
+
+#include <math.h>
+
+static const double PI = 3.14159265;
+
+/** conversion factor from Angle::value_t to radians (the same as
+    Angle::operator double()) */
+static const double RADIANS_PER_VALUE = PI / (180. * 60. * 1000.);
+
+/** the angle between two vertices of a tessellated arc or circle; the
+    polygon is at most 0.015% of the radius off */
+static const double ARC_STEP = 2. * PI / 180.;
+
+/** the desired average number of polygons per grid cell */
+static const unsigned POLYGONS_PER_CELL = 2;
+
+/** the maximum number of rows and columns of the grid */
+static const unsigned MAX_GRID_SIZE = 256;
+
+AirspaceIndex::AirspaceIndex()
+    :min_x(0), max_x(0), min_y(0), max_y(0),
+     rows(0), columns(0)
+{
+    rings.push_back(0);
+}
+
+void
+AirspaceIndex::addVertex(double vx, double vy)
+{
+    x.push_back(vx);
+    y.push_back(vy);
+}
+
+/**
+ * Close the ring which begins with vertex "first", or remove it if it
+ * has less than three vertices.
+ */
+void
+AirspaceIndex::closeRing(unsigned first)
+{
+    if (x.size() < first + 3) {
+        x.resize(first);
+        y.resize(first);
+        return;
+    }
+
+    addVertex(x[first], y[first]);
+    rings.push_back(x.size());
+}
+
+/**
+ * Tessellate an arc from the last vertex to "end".  The radius is
+ * interpolated between the start and the end point, because OpenAir
+ * files often have them at slightly different distances from the
+ * center.  sign > 0 means clockwise.
+ */
+void
+AirspaceIndex::addArc(int sign, const SurfacePosition &end,
+                      const SurfacePosition &center)
+{
+    const double ex = end.getLongitude().getValue();
+    const double ey = end.getLatitude().getValue();
+    const double cx = center.getLongitude().getValue();
+    const double cy = center.getLatitude().getValue();
+
+    /* a local equirectangular projection around the center, where
+       both axes have the same scale */
+    const double scale = cos(cy * RADIANS_PER_VALUE);
+    if (!(scale > 1e-6)) {
+        addVertex(ex, ey);
+        return;
+    }
+
+    const double sx = (x.back() - cx) * scale, sy = y.back() - cy;
+    const double start_angle = atan2(sx, sy);
+    const double start_radius = sqrt(sx * sx + sy * sy);
+    const double end_angle = atan2((ex - cx) * scale, ey - cy);
+    const double end_radius = sqrt((ex - cx) * (ex - cx) * scale * scale +
+                                   (ey - cy) * (ey - cy));
+
+    /* the angle is a bearing, i.e. it grows clockwise */
+    double sweep = end_angle - start_angle;
+    if (sign > 0 && sweep < 0)
+        sweep += 2. * PI;
+    else if (sign < 0 && sweep > 0)
+        sweep -= 2. * PI;
+
+    const unsigned steps = (unsigned)ceil(fabs(sweep) / ARC_STEP);
+    for (unsigned i = 1; i < steps; ++i) {
+        const double f = (double)i / steps;
+        const double angle = start_angle + sweep * f;
+        const double radius = start_radius +
+            (end_radius - start_radius) * f;
+
+        addVertex(cx + radius * sin(angle) / scale,
+                  cy + radius * cos(angle));
+    }
+
+    addVertex(ex, ey);
+}
+
+void
+AirspaceIndex::addCircle(const SurfacePosition &center,
+                         const Distance &radius)
+{
+    const double cx = center.getLongitude().getValue();
+    const double cy = center.getLatitude().getValue();
+    const double scale = cos(cy * RADIANS_PER_VALUE);
+    const double r = centralAngle(radius) / RADIANS_PER_VALUE;
+
+    if (!(scale > 1e-6) || !(r > 0.))
+        return;
+
+    const unsigned first = x.size();
+    const unsigned steps = (unsigned)ceil(2. * PI / ARC_STEP);
+    for (unsigned i = 0; i < steps; ++i) {
+        const double angle = 2. * PI * i / steps;
+        addVertex(cx + r * sin(angle) / scale, cy + r * cos(angle));
+    }
+
+    closeRing(first);
+}
+
+void
+AirspaceIndex::add(const Airspace &airspace)
+{
+    const Airspace::EdgeList &edges = airspace.getEdges();
+    Polygon polygon;
+    unsigned first = x.size();
+
+    polygon.first_ring = rings.size() - 1;
+
+    for (Airspace::EdgeList::const_iterator it = edges.begin();
+         it != edges.end(); ++it) {
+        const Edge &edge = *it;
+
+        switch (edge.getType()) {
+        case Edge::TYPE_VERTEX:
+            if (edge.getEnd().defined())
+                addVertex(edge.getEnd().getLongitude().getValue(),
+                          edge.getEnd().getLatitude().getValue());
+            break;
+
+        case Edge::TYPE_CIRCLE:
+            /* a circle is a ring of its own */
+            closeRing(first);
+            if (edge.getCenter().defined())
+                addCircle(edge.getCenter(), edge.getRadius());
+            first = x.size();
+            break;
+
+        case Edge::TYPE_ARC:
+            if (!edge.getEnd().defined())
+                break;
+
+            if (x.size() > first && edge.getCenter().defined())
+                addArc(edge.getSign(), edge.getEnd(), edge.getCenter());
+            else
+                addVertex(edge.getEnd().getLongitude().getValue(),
+                          edge.getEnd().getLatitude().getValue());
+            break;
+        }
+    }
+
+    closeRing(first);
+
+    polygon.end_ring = rings.size() - 1;
+    if (polygon.end_ring == polygon.first_ring)
+        return;
+
+    const unsigned begin = rings[polygon.first_ring];
+    const unsigned end = rings[polygon.end_ring];
+
+    polygon.min_x = polygon.max_x = x[begin];
+    polygon.min_y = polygon.max_y = y[begin];
+    for (unsigned i = begin + 1; i < end; ++i) {
+        if (x[i] < polygon.min_x)
+            polygon.min_x = x[i];
+        if (x[i] > polygon.max_x)
+            polygon.max_x = x[i];
+        if (y[i] < polygon.min_y)
+            polygon.min_y = y[i];
+        if (y[i] > polygon.max_y)
+            polygon.max_y = y[i];
+    }
+
+    polygons.push_back(polygon);
+}
+
+unsigned
+AirspaceIndex::getRow(double py) const
+{
+    unsigned row = (unsigned)((py - min_y) * rows / (max_y - min_y));
+    return row < rows ? row : rows - 1;
+}
+
+unsigned
+AirspaceIndex::getColumn(double px) const
+{
+    unsigned column = (unsigned)((px - min_x) * columns / (max_x - min_x));
+    return column < columns ? column : columns - 1;
+}
+
+void
+AirspaceIndex::build()
+{
+    unsigned i;
+
+    cell_start.clear();
+    cell_polygons.clear();
+
+    if (polygons.empty()) {
+        rows = columns = 0;
+        return;
+    }
+
+    /* determine the bounding box */
+
+    min_x = polygons[0].min_x;
+    max_x = polygons[0].max_x;
+    min_y = polygons[0].min_y;
+    max_y = polygons[0].max_y;
+    for (i = 1; i < polygons.size(); ++i) {
+        if (polygons[i].min_x < min_x)
+            min_x = polygons[i].min_x;
+        if (polygons[i].max_x > max_x)
+            max_x = polygons[i].max_x;
+        if (polygons[i].min_y < min_y)
+            min_y = polygons[i].min_y;
+        if (polygons[i].max_y > max_y)
+            max_y = polygons[i].max_y;
+    }
+
+    /* avoid empty ranges */
+    max_x += 1.;
+    max_y += 1.;
+
+    rows = (unsigned)ceil(sqrt((double)(polygons.size() /
+                                        POLYGONS_PER_CELL)));
+    if (rows < 1)
+        rows = 1;
+    else if (rows > MAX_GRID_SIZE)
+        rows = MAX_GRID_SIZE;
+    columns = rows;
+
+    /* add each polygon to all cells which its bounding box
+       overlaps; the cells are filled in two passes (count, then
+       fill), which keeps the polygons in ascending order */
+
+    cell_start.assign(rows * columns + 1, 0);
+
+    for (unsigned pass = 0; pass < 2; ++pass) {
+        std::vector<unsigned> fill;
+        if (pass == 1) {
+            for (i = 1; i < cell_start.size(); ++i)
+                cell_start[i] += cell_start[i - 1];
+
+            fill.assign(cell_start.begin(), cell_start.end() - 1);
+            cell_polygons.resize(cell_start.back());
+        }
+
+        for (i = 0; i < polygons.size(); ++i) {
+            const Polygon &polygon = polygons[i];
+            const unsigned row1 = getRow(polygon.min_y);
+            const unsigned row2 = getRow(polygon.max_y);
+            const unsigned column1 = getColumn(polygon.min_x);
+            const unsigned column2 = getColumn(polygon.max_x);
+
+            for (unsigned row = row1; row <= row2; ++row) {
+                for (unsigned column = column1; column <= column2;
+                     ++column) {
+                    const unsigned cell = row * columns + column;
+                    if (pass == 0)
+                        ++cell_start[cell + 1];
+                    else
+                        cell_polygons[fill[cell]++] = i;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Count how often a ray from (px, py) in positive x direction crosses
+ * the edges of a ring with n vertices (n - 1 edges).  The loop has no
+ * branches and no divisions, so the compiler can vectorize it.
+ */
+static unsigned
+count_crossings(const double *x, const double *y, unsigned n,
+                double px, double py)
+{
+    unsigned crossings = 0;
+
+    for (unsigned i = 0; i + 1 < n; ++i) {
+        const double dx = x[i + 1] - x[i], dy = y[i + 1] - y[i];
+        const bool straddles = (y[i] > py) != (y[i + 1] > py);
+
+        /* is (px, py) left of the edge's intersection with the ray?
+           multiplied by dy, which flips the comparison if dy is
+           negative */
+        const bool left = ((px - x[i]) * dy < dx * (py - y[i])) != (dy < 0.);
+
+        crossings += straddles & left;
+    }
+
+    return crossings;
+}
+
+bool
+AirspaceIndex::polygonContains(const Polygon &polygon,
+                               double px, double py) const
+{
+    if (px < polygon.min_x || px > polygon.max_x ||
+        py < polygon.min_y || py > polygon.max_y)
+        return false;
+
+    /* even-odd rule over all rings, so rings inside other rings are
+       holes */
+    unsigned crossings = 0;
+    for (unsigned ring = polygon.first_ring; ring < polygon.end_ring; ++ring)
+        crossings += count_crossings(&x[rings[ring]], &y[rings[ring]],
+                                     rings[ring + 1] - rings[ring],
+                                     px, py);
+
+    return (crossings & 1) != 0;
+}
+
+bool
+AirspaceIndex::contains(const SurfacePosition &position) const
+{
+    if (rows == 0 || !position.defined())
+        return false;
+
+    const double px = position.getLongitude().getValue();
+    const double py = position.getLatitude().getValue();
+
+    if (px < min_x || px >= max_x || py < min_y || py >= max_y)
+        return false;
+
+    const unsigned cell = getRow(py) * columns + getColumn(px);
+    for (unsigned i = cell_start[cell]; i < cell_start[cell + 1]; ++i)
+        if (polygonContains(polygons[cell_polygons[i]], px, py))
+            return true;
+
+    return false;
+}
@@ -0,0 +1,96 @@
+/*
+ * loggertools
+ * Copyright (C) 2004-2008 Max Kellermann <max@duempel.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; version 2 of the License
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef __LOGGERTOOLS_AIRSPACE_INDEX_HH
+#define __LOGGERTOOLS_AIRSPACE_INDEX_HH
+
+#include "airspace.hh"
+
+#include <vector>
+
+/**
+ * The outlines of a number of airspaces as polygons, with a lat/lon
+ * grid index of their bounding boxes, which answers "is this point
+ * inside one of the airspaces?" without looking at all of them.
+ *
+ * Arcs and circles are converted to polygons once by add().
+ * Coordinates are Angle values (longitude as x, latitude as y);
+ * airspaces crossing the 180th meridian are not supported.
+ */
+class AirspaceIndex {
+private:
+    struct Polygon {
+        /** the rings of this polygon are rings[first_ring] up to
+            rings[end_ring] (exclusive) */
+        unsigned first_ring, end_ring;
+
+        /** the bounding box */
+        double min_x, max_x, min_y, max_y;
+    };
+
+    std::vector<Polygon> polygons;
+
+    /** ring n consists of the vertices x[rings[n]] up to
+        x[rings[n + 1]] (exclusive); the last one is a copy of the
+        first one, which closes the ring */
+    std::vector<unsigned> rings;
+    std::vector<double> x, y;
+
+    /** the bounding box covered by the grid */
+    double min_x, max_x, min_y, max_y;
+    unsigned rows, columns;
+
+    /** cell n contains the polygons cell_polygons[cell_start[n]]
+        up to cell_polygons[cell_start[n + 1]] (exclusive) */
+    std::vector<unsigned> cell_start, cell_polygons;
+
+public:
+    AirspaceIndex();
+
+    size_t size() const {
+        return polygons.size();
+    }
+
+    /**
+     * Add the outline of an airspace.  build() must be called before
+     * the next contains() call.
+     */
+    void add(const Airspace &airspace);
+
+    void build();
+
+    /**
+     * Is the position inside one of the airspaces?
+     */
+    bool contains(const SurfacePosition &position) const;
+
+private:
+    void addVertex(double vx, double vy);
+    void addArc(int sign, const SurfacePosition &end,
+                const SurfacePosition &center);
+    void addCircle(const SurfacePosition &center, const Distance &radius);
+    void closeRing(unsigned first);
+
+    unsigned getRow(double py) const;
+    unsigned getColumn(double px) const;
+    bool polygonContains(const Polygon &polygon,
+                         double px, double py) const;
+};
+
+#endif
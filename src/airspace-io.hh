@@ -24,6 +24,7 @@
 #include "airspace.hh"
 
 typedef Reader<Airspace> AirspaceReader;
+typedef RecordReader<Airspace> AirspaceRecordReader;
 typedef Writer<Airspace> AirspaceWriter;
 typedef Format<Airspace> AirspaceFormat;
 
@@ -68,10 +68,15 @@ public:
     }
 };
 
-class OpenAirAirspaceReader : public AirspaceReader {
+class OpenAirAirspaceReader : public AirspaceRecordReader {
 private:
     LineInputStream stream;
 
+    /** the edges of the current airspace; they are swapped with the
+        old edges of the destination object, so their memory is
+        reused */
+    Airspace::EdgeList edges;
+
 public:
     OpenAirAirspaceReader(std::istream *stream);
 
@@ -81,10 +86,10 @@ private:
      */
     void skip();
 
-    const Airspace *read_internal();
+    bool read_internal(Airspace &dest);
 
 public:
-    virtual const Airspace *read();
+    virtual bool read_into(Airspace &dest);
 };
 
 OpenAirAirspaceReader::OpenAirAirspaceReader(std::istream *_stream)
@@ -212,7 +217,7 @@ last_edge_equals(const Airspace::EdgeList &edges, const SurfacePosition &sp)
     if (edges.size() == 0)
         return false;
 
-    const Edge &last = *(--edges.end());
+    const Edge &last = edges.back();
     return last.getType() == Edge::TYPE_VERTEX && last.getEnd() == sp;
 }
 
@@ -245,17 +250,18 @@ OpenAirAirspaceReader::skip()
     }
 }
 
-const Airspace *
-OpenAirAirspaceReader::read_internal()
+bool
+OpenAirAirspaceReader::read_internal(Airspace &dest)
 {
     char buffer[512], *line;
     Airspace::type_t type = Airspace::TYPE_UNKNOWN;
     std::string name;
     Altitude bottom, top;
-    Airspace::EdgeList edges;
     SurfacePosition x;
     int direction = 1;
 
+    edges.clear();
+
     while (!stream.eof()) {
         try {
             stream.getline(buffer, sizeof(buffer));
@@ -376,19 +382,18 @@ OpenAirAirspaceReader::read_internal()
         }
     }
 
-    if (edges.size() > 0)
-        return new Airspace(name, type,
-                            bottom, top,
-                            edges);
+    if (edges.empty())
+        return false;
 
-    return NULL;
+    dest.assign(name, type, bottom, top, Altitude(), edges, Frequency(), 0);
+    return true;
 }
 
-const Airspace *
-OpenAirAirspaceReader::read()
+bool
+OpenAirAirspaceReader::read_into(Airspace &dest)
 {
     try {
-        return read_internal();
+        return read_internal(dest);
     } catch (const malformed_input &e) {
         throw malformed_input(e, stream.get_location());
     }
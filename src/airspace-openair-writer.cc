@@ -198,9 +198,8 @@ void OpenAirAirspaceWriter::write(const Airspace &as) {
         *stream << "AH " << as.getTop() << "\n";
 
     const Airspace::EdgeList &edges = as.getEdges();
-    for (Airspace::EdgeList::const_iterator it = edges.begin();
-         it != edges.end(); ++it) {
-        const Edge &edge = (*it);
+    for (size_t i = 0; i < edges.size(); ++i) {
+        const Edge &edge = edges[i];
         switch (edge.getType()) {
         case Edge::TYPE_VERTEX:
             write_vertex(*stream, edge);
@@ -211,12 +210,8 @@ void OpenAirAirspaceWriter::write(const Airspace &as) {
             break;
 
         case Edge::TYPE_ARC:
-            if (it != edges.begin()) {
-                Airspace::EdgeList::const_iterator prev = it;
-                --prev;
-                if (prev->getType() == Edge::TYPE_VERTEX)
-                    write_arc(*stream, edge, *prev);
-            }
+            if (i > 0 && edges[i - 1].getType() == Edge::TYPE_VERTEX)
+                write_arc(*stream, edge, edges[i - 1]);
             break;
         }
     }
@@ -24,8 +24,6 @@
 #include <ostream>
 #include <iomanip>
 
-#include <assert.h>
-
 class SVGAirspaceWriter : public AirspaceWriter {
 public:
     std::ostream &stream;
@@ -116,16 +114,15 @@ SVGAirspaceWriter::write(const Airspace &as)
     stream << "  <g>\n";
     stream << "  <path d=\"";
 
-    Airspace::EdgeList circles;
-
     const Airspace::EdgeList &edges = as.getEdges();
-    for (Airspace::EdgeList::const_iterator it = edges.begin();
-         it != edges.end(); ++it) {
-        const Edge &edge = *it;
+    bool has_circles = false;
+
+    for (size_t i = 0; i < edges.size(); ++i) {
+        const Edge &edge = edges[i];
 
         switch (edge.getType()) {
         case Edge::TYPE_VERTEX:
-            if (it == edges.begin())
+            if (i == 0)
                 stream << "M";
             else
                 stream << "L";
@@ -134,7 +131,7 @@ SVGAirspaceWriter::write(const Airspace &as)
             break;
 
         case Edge::TYPE_CIRCLE:
-            circles.push_back(edge);
+            has_circles = true;
             break;
 
         case Edge::TYPE_ARC:
@@ -148,10 +145,10 @@ SVGAirspaceWriter::write(const Airspace &as)
 
     stream << "Z\" style=\"" << airspace_style(as) << "\"/>\n";
 
-    for (Airspace::EdgeList::const_iterator it = circles.begin();
-         it != circles.end(); ++it) {
-        const Edge &edge = *it;
-        assert(edge.getType() == Edge::TYPE_CIRCLE);
+    for (size_t i = 0; has_circles && i < edges.size(); ++i) {
+        const Edge &edge = edges[i];
+        if (edge.getType() != Edge::TYPE_CIRCLE)
+            continue;
 
         stream << "<circle cx=\"" << edge.getCenter().getLongitude()
                << "\" cy=\"" << edge.getCenter().getLatitude()
@@ -264,9 +264,8 @@ void ZanderAirspaceWriter::write(const Airspace &as) {
 
     char vertex_symbol = 'S';
     const Airspace::EdgeList &edges = as.getEdges();
-    for (Airspace::EdgeList::const_iterator it = edges.begin();
-         it != edges.end(); ++it) {
-        const Edge &edge = (*it);
+    for (size_t i = 0; i < edges.size(); ++i) {
+        const Edge &edge = edges[i];
         switch (edge.getType()) {
         case Edge::TYPE_VERTEX:
             write_vertex(*stream, edge, vertex_symbol);
@@ -278,18 +277,14 @@ void ZanderAirspaceWriter::write(const Airspace &as) {
             break;
 
         case Edge::TYPE_ARC:
-            if (it != edges.begin()) {
-                Airspace::EdgeList::const_iterator prev = it;
-                --prev;
-                if (prev->getType() == Edge::TYPE_VERTEX)
-                    write_arc(*stream, edge, *prev);
-            }
+            if (i > 0 && edges[i - 1].getType() == Edge::TYPE_VERTEX)
+                write_arc(*stream, edge, edges[i - 1]);
             break;
         }
     }
 
-    if (!edges.empty() && edges.begin()->getType() == Edge::TYPE_VERTEX)
-        write_vertex(*stream, *edges.begin(), vertex_symbol);
+    if (!edges.empty() && edges.front().getType() == Edge::TYPE_VERTEX)
+        write_vertex(*stream, edges.front(), vertex_symbol);
 
     *stream << "\n";
 }
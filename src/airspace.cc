@@ -19,6 +19,10 @@
 
 #include "airspace.hh"
 
+Airspace::Airspace()
+    :type(TYPE_UNKNOWN), voice(0) {
+}
+
 Airspace::Airspace(const std::string &_name, type_t _type,
                    const Altitude &_bottom, const Altitude &_top,
                    const EdgeList &_edges)
@@ -40,3 +44,21 @@ Airspace::Airspace(const std::string &_name, type_t _type,
      frequency(_frequency),
      voice(_voice) {
 }
+
+void
+Airspace::assign(const std::string &_name, type_t _type,
+                 const Altitude &_bottom, const Altitude &_top,
+                 const Altitude &_top2,
+                 EdgeList &_edges,
+                 const Frequency &_frequency,
+                 unsigned _voice)
+{
+    name = _name;
+    type = _type;
+    bottom = _bottom;
+    top = _top;
+    top2 = _top2;
+    edges.swap(_edges);
+    frequency = _frequency;
+    voice = _voice;
+}
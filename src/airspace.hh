@@ -24,7 +24,7 @@
 #include "aviation.hh"
 
 #include <string>
-#include <list>
+#include <vector>
 
 class Edge {
 public:
@@ -115,7 +115,11 @@ public:
         TYPE_DANGER,
         TYPE_GLIDER
     };
-    typedef std::list<Edge> EdgeList;
+
+    /** the edges in one contiguous array; readers build it in their
+        own EdgeList, and pass it with assign(), which swaps instead of
+        copying */
+    typedef std::vector<Edge> EdgeList;
 private:
     std::string name;
     type_t type;
@@ -132,6 +136,7 @@ private:
     unsigned voice;
 
 public:
+    Airspace();
     Airspace(const std::string &name, type_t type,
              const Altitude &bottom, const Altitude &top,
              const EdgeList &edges);
@@ -141,6 +146,19 @@ public:
              const Frequency &_frequency,
              unsigned voice);
 
+public:
+    /**
+     * Replace all properties of this object.  The edge list is not
+     * copied, it is swapped with the specified one, i.e. the caller
+     * gets the old edges back.
+     */
+    void assign(const std::string &name, type_t type,
+                const Altitude &bottom, const Altitude &top,
+                const Altitude &top2,
+                EdgeList &edges,
+                const Frequency &_frequency,
+                unsigned voice);
+
 public:
     const std::string &getName() const {
         return name;
@@ -0,0 +1,243 @@
+/*
+ * loggertools
+ * Copyright (C) 2004-2008 Max Kellermann <max@duempel.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; version 2 of the License
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include "earth-batch.hh"
+
+#include <math.h>
+
+/* NO_SIMD disables the SSE2 and AVX code, so the portable code can be
+   checked on x86, see test/check-earth-batch.cc */
+#if defined(NO_SIMD)
+#elif defined(__AVX__)
+#define USE_AVX
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#define USE_SSE2
+#include <emmintrin.h>
+#endif
+
+/** the earth radius used by operator -(SurfacePosition, SurfacePosition) */
+static const double EARTH_RADIUS = 6372795.;
+
+/** the uncertainty of a dot product calculated by dot_batch() */
+static const double DOT_EPSILON = 1e-12;
+
+/**
+ * Calculate the dot products of the unit vector "a" with n unit
+ * vectors.
+ */
+static void
+dot_batch(const double a[3], const double *x, const double *y,
+          const double *z, size_t n, double *dot)
+{
+    size_t i = 0;
+
+#if defined(USE_AVX)
+    const __m256d ax = _mm256_set1_pd(a[0]);
+    const __m256d ay = _mm256_set1_pd(a[1]);
+    const __m256d az = _mm256_set1_pd(a[2]);
+
+    for (; i + 4 <= n; i += 4) {
+        const __m256d bx = _mm256_loadu_pd(x + i);
+        const __m256d by = _mm256_loadu_pd(y + i);
+        const __m256d bz = _mm256_loadu_pd(z + i);
+        __m256d d = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(ax, bx),
+                                                _mm256_mul_pd(ay, by)),
+                                  _mm256_mul_pd(az, bz));
+        _mm256_storeu_pd(dot + i, d);
+    }
+#elif defined(USE_SSE2)
+    const __m128d ax = _mm_set1_pd(a[0]);
+    const __m128d ay = _mm_set1_pd(a[1]);
+    const __m128d az = _mm_set1_pd(a[2]);
+
+    for (; i + 2 <= n; i += 2) {
+        const __m128d bx = _mm_loadu_pd(x + i);
+        const __m128d by = _mm_loadu_pd(y + i);
+        const __m128d bz = _mm_loadu_pd(z + i);
+        __m128d d = _mm_add_pd(_mm_add_pd(_mm_mul_pd(ax, bx),
+                                          _mm_mul_pd(ay, by)),
+                               _mm_mul_pd(az, bz));
+        _mm_storeu_pd(dot + i, d);
+    }
+#endif
+
+    for (; i < n; ++i)
+        dot[i] = a[0] * x[i] + a[1] * y[i] + a[2] * z[i];
+}
+
+/**
+ * Calculate the lengths of the cross products of the unit vector "a"
+ * with n unit vectors.
+ */
+static void
+cross_batch(const double a[3], const double *x, const double *y,
+            const double *z, size_t n, double *cross)
+{
+    size_t i = 0;
+
+#if defined(USE_AVX)
+    const __m256d ax = _mm256_set1_pd(a[0]);
+    const __m256d ay = _mm256_set1_pd(a[1]);
+    const __m256d az = _mm256_set1_pd(a[2]);
+
+    for (; i + 4 <= n; i += 4) {
+        const __m256d bx = _mm256_loadu_pd(x + i);
+        const __m256d by = _mm256_loadu_pd(y + i);
+        const __m256d bz = _mm256_loadu_pd(z + i);
+        const __m256d cx = _mm256_sub_pd(_mm256_mul_pd(ay, bz),
+                                         _mm256_mul_pd(az, by));
+        const __m256d cy = _mm256_sub_pd(_mm256_mul_pd(az, bx),
+                                         _mm256_mul_pd(ax, bz));
+        const __m256d cz = _mm256_sub_pd(_mm256_mul_pd(ax, by),
+                                         _mm256_mul_pd(ay, bx));
+        __m256d c = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(cx, cx),
+                                                _mm256_mul_pd(cy, cy)),
+                                  _mm256_mul_pd(cz, cz));
+        _mm256_storeu_pd(cross + i, _mm256_sqrt_pd(c));
+    }
+#elif defined(USE_SSE2)
+    const __m128d ax = _mm_set1_pd(a[0]);
+    const __m128d ay = _mm_set1_pd(a[1]);
+    const __m128d az = _mm_set1_pd(a[2]);
+
+    for (; i + 2 <= n; i += 2) {
+        const __m128d bx = _mm_loadu_pd(x + i);
+        const __m128d by = _mm_loadu_pd(y + i);
+        const __m128d bz = _mm_loadu_pd(z + i);
+        const __m128d cx = _mm_sub_pd(_mm_mul_pd(ay, bz), _mm_mul_pd(az, by));
+        const __m128d cy = _mm_sub_pd(_mm_mul_pd(az, bx), _mm_mul_pd(ax, bz));
+        const __m128d cz = _mm_sub_pd(_mm_mul_pd(ax, by), _mm_mul_pd(ay, bx));
+        __m128d c = _mm_add_pd(_mm_add_pd(_mm_mul_pd(cx, cx),
+                                          _mm_mul_pd(cy, cy)),
+                               _mm_mul_pd(cz, cz));
+        _mm_storeu_pd(cross + i, _mm_sqrt_pd(c));
+    }
+#endif
+
+    for (; i < n; ++i) {
+        const double cx = a[1] * z[i] - a[2] * y[i];
+        const double cy = a[2] * x[i] - a[0] * z[i];
+        const double cz = a[0] * y[i] - a[1] * x[i];
+        cross[i] = sqrt(cx * cx + cy * cy + cz * cz);
+    }
+}
+
+void
+PositionBatch::clear()
+{
+    latitudes.clear();
+    longitudes.clear();
+    x.clear();
+    y.clear();
+    z.clear();
+}
+
+void
+PositionBatch::reserve(size_t n)
+{
+    latitudes.reserve(n);
+    longitudes.reserve(n);
+    x.reserve(n);
+    y.reserve(n);
+    z.reserve(n);
+}
+
+void
+PositionBatch::append(const SurfacePosition &position)
+{
+    const PreparedPosition prepared(position);
+
+    latitudes.push_back(position.getLatitude().getValue());
+    longitudes.push_back(position.getLongitude().getValue());
+    x.push_back(prepared.getX());
+    y.push_back(prepared.getY());
+    z.push_back(prepared.getZ());
+}
+
+void
+PositionBatch::distances(const SurfacePosition &reference,
+                         size_t begin, size_t end, double *result) const
+{
+    const size_t n = end - begin;
+    if (n == 0)
+        return;
+
+    if (!reference.defined()) {
+        for (size_t i = begin; i < end; ++i)
+            result[i - begin] = ((*this)[i] - reference).getMeters();
+        return;
+    }
+
+    const PreparedPosition prepared(reference);
+    const double a[3] = {
+        prepared.getX(), prepared.getY(), prepared.getZ(),
+    };
+
+    std::vector<double> cross(n);
+    dot_batch(a, &x[begin], &y[begin], &z[begin], n, result);
+    cross_batch(a, &x[begin], &y[begin], &z[begin], n, &cross[0]);
+
+    for (size_t i = 0; i < n; ++i) {
+        if (isnan(x[begin + i]))
+            /* undefined position: let operator-() decide what to
+               return */
+            result[i] = ((*this)[begin + i] - reference).getMeters();
+        else
+            result[i] = atan2(cross[i], result[i]) * EARTH_RADIUS;
+    }
+}
+
+void
+PositionBatch::within(const SurfacePosition &center, const Distance &radius,
+                      size_t begin, size_t end,
+                      unsigned char *result) const
+{
+    const size_t n = end - begin;
+    const double r = radius.getMeters() / EARTH_RADIUS;
+    if (n == 0)
+        return;
+
+    if (!center.defined() || !(r >= 0.) || r >= 3.) {
+        for (size_t i = begin; i < end; ++i)
+            result[i - begin] = (*this)[i] - center <= radius;
+        return;
+    }
+
+    const PreparedPosition prepared(center);
+    const double a[3] = {
+        prepared.getX(), prepared.getY(), prepared.getZ(),
+    };
+
+    /* compare the dot product with the cosine of the radius;
+       operator-() is only called when it's too close to decide */
+    const double cos_r = cos(r);
+    std::vector<double> dot(n);
+    dot_batch(a, &x[begin], &y[begin], &z[begin], n, &dot[0]);
+
+    for (size_t i = 0; i < n; ++i) {
+        if (dot[i] > cos_r + DOT_EPSILON)
+            result[i] = 1;
+        else if (dot[i] < cos_r - DOT_EPSILON)
+            result[i] = 0;
+        else
+            /* near the border, or NaN (undefined position) */
+            result[i] = (*this)[begin + i] - center <= radius;
+    }
+}
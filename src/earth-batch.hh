@@ -0,0 +1,74 @@
+/*
+ * loggertools
+ * Copyright (C) 2004-2008 Max Kellermann <max@duempel.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; version 2 of the License
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef __LOGGERTOOLS_EARTH_BATCH_HH
+#define __LOGGERTOOLS_EARTH_BATCH_HH
+
+#include "earth.hh"
+
+#include <vector>
+
+#include <stddef.h>
+
+/**
+ * A list of positions on the earth's surface, stored as separate
+ * arrays (latitude, longitude and the unit vector), for calculating
+ * the distance from one reference point to many positions at once.
+ * The calculation uses SSE2 or AVX if the compiler supports it.
+ */
+class PositionBatch {
+private:
+    std::vector<Angle::value_t> latitudes, longitudes;
+
+    /** the unit vectors; NaN if the position is not defined */
+    std::vector<double> x, y, z;
+
+public:
+    size_t size() const {
+        return x.size();
+    }
+
+    void clear();
+    void reserve(size_t n);
+    void append(const SurfacePosition &position);
+
+    const SurfacePosition operator [](size_t i) const {
+        return SurfacePosition(Latitude(latitudes[i]),
+                               Longitude(longitudes[i]));
+    }
+
+    /**
+     * Calculate the great circle distance in meters from the
+     * reference to the positions begin..end-1.
+     */
+    void distances(const SurfacePosition &reference,
+                   size_t begin, size_t end, double *result) const;
+
+    /**
+     * For each of the positions begin..end-1, set result[i - begin]
+     * to 1 if "position - center <= radius", and to 0 otherwise.  The result is the
+     * same as the one of operator-(), because that is called for
+     * positions near the border.
+     */
+    void within(const SurfacePosition &center, const Distance &radius,
+                size_t begin, size_t end,
+                unsigned char *result) const;
+};
+
+#endif
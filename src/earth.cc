@@ -21,6 +21,7 @@
 
 #include <assert.h>
 #include <math.h>
+#include <stdlib.h>
 
 Altitude::Altitude()
     :value(0), unit(UNIT_UNKNOWN), ref(REF_UNKNOWN) {
@@ -76,3 +77,202 @@ const Distance operator -(const SurfacePosition& a, const SurfacePosition &b) {
                            cos(lat1) * cos(lat2) * cos(lon2 - lon1))) *
                     6372795.);
 }
+
+/** the earth radius used by operator -(SurfacePosition, SurfacePosition) */
+static const double EARTH_RADIUS = 6372795.;
+
+static const double HALF_PI = 3.14159265 / 2.;
+
+/** conversion factor from Angle::value_t to radians (the same as
+    Angle::operator double()) */
+static const double RADIANS_PER_VALUE = 3.14159265 / (180. * 60. * 1000.);
+
+static const Angle::value_t MAX_LATITUDE = 90 * 60 * 1000;
+static const Angle::value_t MAX_LONGITUDE = 180 * 60 * 1000;
+
+/** the uncertainty of a dot product of two unit vectors; closer to
+    cos(radius) than that, the exact distance must be calculated */
+static const double DOT_EPSILON = 1e-12;
+
+PreparedPosition::PreparedPosition()
+    :x(NAN), y(NAN), z(NAN) {}
+
+PreparedPosition::PreparedPosition(const SurfacePosition &_position)
+    :position(_position), x(NAN), y(NAN), z(NAN) {
+    if (!position.defined())
+        return;
+
+    const double latitude = position.getLatitude();
+    const double longitude = position.getLongitude();
+    const double cos_latitude = cos(latitude);
+
+    x = cos_latitude * cos(longitude);
+    y = cos_latitude * sin(longitude);
+    z = sin(latitude);
+}
+
+const Distance operator -(const PreparedPosition &a,
+                          const PreparedPosition &b) {
+    if (!a.defined() || !b.defined())
+        return a.getPosition() - b.getPosition();
+
+    const double cx = a.getY() * b.getZ() - a.getZ() * b.getY();
+    const double cy = a.getZ() * b.getX() - a.getX() * b.getZ();
+    const double cz = a.getX() * b.getY() - a.getY() * b.getX();
+
+    return Distance(Distance::UNIT_METERS,
+                    atan2(sqrt(cx * cx + cy * cy + cz * cz), a.dot(b)) *
+                    EARTH_RADIUS);
+}
+
+double
+chordLength(const Distance &distance)
+{
+    const double r = distance.getMeters() / EARTH_RADIUS;
+    if (r >= 2 * HALF_PI)
+        return 2.;
+
+    return 2. * sin(r / 2.);
+}
+
+double
+centralAngle(const Distance &distance)
+{
+    return distance.getMeters() / EARTH_RADIUS;
+}
+
+/**
+ * Is this a valid position, for which the bounding box test works?
+ */
+static bool
+is_normal(const SurfacePosition &position)
+{
+    return position.defined() &&
+        position.getLatitude().getValue() >= -MAX_LATITUDE &&
+        position.getLatitude().getValue() <= MAX_LATITUDE &&
+        position.getLongitude().getValue() >= -MAX_LONGITUDE &&
+        position.getLongitude().getValue() <= MAX_LONGITUDE;
+}
+
+SurfaceCircle::SurfaceCircle(const SurfacePosition &_center,
+                             const Distance &_radius)
+    :center(_center), radius(_radius),
+     prepared_center(_center), cos_radius(NAN),
+     bounded(false),
+     min_latitude(-MAX_LATITUDE), max_latitude(MAX_LATITUDE),
+     min_longitude(-MAX_LONGITUDE), max_longitude(MAX_LONGITUDE),
+     inner_radius(-1.), max_cos_latitude(1.) {
+    const double r = radius.getMeters() / EARTH_RADIUS;
+
+    if (center.defined() && r >= 0. && r < 3.)
+        cos_radius = cos(r);
+
+    if (!is_normal(center) || !(r >= 0.) || r >= HALF_PI)
+        return;
+
+    bounded = true;
+
+    /* the box is made a bit larger, and the inner radius a bit
+       smaller, to be safe from rounding errors (and from the
+       imprecise pi in Angle::operator double(), which matters at
+       the date line); the exact distance is calculated for
+       everything in between */
+    const double outer = r * 1.0001 + 1e-7;
+    const double latitude = center.getLatitude();
+    const double longitude = center.getLongitude();
+
+    double lat1 = latitude - outer, lat2 = latitude + outer;
+
+    if (lat1 < -HALF_PI)
+        lat1 = -HALF_PI;
+    if (lat2 > HALF_PI)
+        lat2 = HALF_PI;
+
+    min_latitude = (Angle::value_t)floor(lat1 / RADIANS_PER_VALUE);
+    max_latitude = (Angle::value_t)ceil(lat2 / RADIANS_PER_VALUE);
+
+    if (lat1 > -HALF_PI && lat2 < HALF_PI) {
+        /* the circle does not contain a pole */
+        const double delta = asin(sin(outer) / cos(latitude));
+        double lon1 = floor((longitude - delta) / RADIANS_PER_VALUE);
+        double lon2 = ceil((longitude + delta) / RADIANS_PER_VALUE);
+
+        if (lon1 < -MAX_LONGITUDE)
+            lon1 += 2 * MAX_LONGITUDE;
+        if (lon2 > MAX_LONGITUDE)
+            lon2 -= 2 * MAX_LONGITUDE;
+
+        min_longitude = (Angle::value_t)lon1;
+        max_longitude = (Angle::value_t)lon2;
+    }
+
+    if (lat1 <= 0. && lat2 >= 0.)
+        max_cos_latitude = 1.;
+    else
+        max_cos_latitude = cos(lat1 > 0. ? lat1 : lat2);
+
+    inner_radius = r * 0.9999 - 1e-7;
+}
+
+bool
+SurfaceCircle::containsNear(const SurfacePosition &position) const
+{
+    if (isnan(cos_radius))
+        return position - center <= radius;
+
+    return contains(PreparedPosition(position));
+}
+
+bool
+SurfaceCircle::contains(const SurfacePosition &position) const
+{
+    if (!bounded || !is_normal(position))
+        return containsNear(position);
+
+    const Angle::value_t latitude = position.getLatitude().getValue();
+    const Angle::value_t longitude = position.getLongitude().getValue();
+
+    /* outside of the bounding box? */
+
+    if (latitude < min_latitude || latitude > max_latitude)
+        return false;
+
+    if (min_longitude <= max_longitude
+        ? (longitude < min_longitude || longitude > max_longitude)
+        : (longitude < min_longitude && longitude > max_longitude))
+        return false;
+
+    /* surely inside?  Walking along the meridian and then along the
+       parallel is never shorter than the great circle */
+
+    long delta_latitude = labs((long)latitude -
+                               center.getLatitude().getValue());
+    long delta_longitude = labs((long)longitude -
+                                center.getLongitude().getValue());
+    if (delta_longitude > MAX_LONGITUDE)
+        delta_longitude = 2 * MAX_LONGITUDE - delta_longitude;
+
+    if ((delta_latitude + delta_longitude * max_cos_latitude) *
+        RADIANS_PER_VALUE <= inner_radius)
+        return true;
+
+    /* near the border */
+
+    return containsNear(position);
+}
+
+bool
+SurfaceCircle::contains(const PreparedPosition &position) const
+{
+    /* compare the dot product with the cosine of the radius; this
+       is false if one of them is NaN */
+    const double dot = prepared_center.dot(position);
+    if (dot > cos_radius + DOT_EPSILON)
+        return true;
+    if (dot < cos_radius - DOT_EPSILON)
+        return false;
+
+    /* too close to decide, or undefined: calculate the exact
+       distance */
+    return position.getPosition() - center <= radius;
+}
@@ -54,7 +54,7 @@ public:
         case UNIT_FEET:
             return value / 3.2808399;
         case UNIT_NAUTICAL_MILES:
-            return value / 1.852;
+            return value * 1852.;
         }
 
         return 0.0;
@@ -316,4 +316,152 @@ public:
 /** calculate the great circle distance */
 const Distance operator -(const SurfacePosition& a, const SurfacePosition &b);
 
+/**
+ * A SurfacePosition together with its unit vector.  When one
+ * position is compared with many others, preparing it once saves the
+ * sin() and cos() calls of operator-(); each distance then costs one
+ * dot product and one atan2().
+ */
+class PreparedPosition {
+private:
+    SurfacePosition position;
+
+    /** the unit vector; NaN if the position is not defined */
+    double x, y, z;
+
+public:
+    PreparedPosition();
+    explicit PreparedPosition(const SurfacePosition &_position);
+
+public:
+    bool defined() const {
+        return position.defined();
+    }
+
+    const SurfacePosition &getPosition() const {
+        return position;
+    }
+
+    double getX() const {
+        return x;
+    }
+
+    double getY() const {
+        return y;
+    }
+
+    double getZ() const {
+        return z;
+    }
+
+    /** the cosine of the angle between the two positions; NaN if
+        one of them is not defined */
+    double dot(const PreparedPosition &b) const {
+        return x * b.x + y * b.y + z * b.z;
+    }
+};
+
+/**
+ * Calculate the great circle distance.  The result may differ from
+ * the one of operator-(SurfacePosition, SurfacePosition) in the last
+ * digits.
+ */
+const Distance operator -(const PreparedPosition &a,
+                          const PreparedPosition &b);
+
+/**
+ * The maximum distance between the unit vectors of two positions
+ * which are at most this far apart on the surface (the length of the
+ * chord on the unit sphere).
+ */
+double chordLength(const Distance &distance);
+
+/**
+ * The angle (in radians) between the unit vectors of two positions
+ * which are this far apart on the surface.
+ */
+double centralAngle(const Distance &distance);
+
+/**
+ * A circle on the earth's surface.  contains() checks a bounding box
+ * first, so the great circle distance is only calculated for
+ * positions near the border.
+ */
+class SurfaceCircle {
+private:
+    SurfacePosition center;
+    Distance radius;
+
+    PreparedPosition prepared_center;
+
+    /** the cosine of the radius, for comparing with the dot product
+        of two unit vectors; NaN if this cannot be used */
+    double cos_radius;
+
+    /** false if there is no bounding box, e.g. because the center is
+        not defined; contains() calculates the exact distance then */
+    bool bounded;
+
+    /** the bounding box; if min_longitude > max_longitude, then it
+        wraps around at 180 degrees */
+    Angle::value_t min_latitude, max_latitude;
+    Angle::value_t min_longitude, max_longitude;
+
+    /** positions whose distance estimate (in radians) is below this
+        are inside */
+    double inner_radius;
+
+    /** the maximum cosine of all latitudes in the bounding box */
+    double max_cos_latitude;
+
+public:
+    SurfaceCircle(const SurfacePosition &_center, const Distance &_radius);
+
+public:
+    const SurfacePosition &getCenter() const {
+        return center;
+    }
+
+    const Distance &getRadius() const {
+        return radius;
+    }
+
+    bool isBounded() const {
+        return bounded;
+    }
+
+    Angle::value_t getMinLatitude() const {
+        return min_latitude;
+    }
+
+    Angle::value_t getMaxLatitude() const {
+        return max_latitude;
+    }
+
+    Angle::value_t getMinLongitude() const {
+        return min_longitude;
+    }
+
+    Angle::value_t getMaxLongitude() const {
+        return max_longitude;
+    }
+
+    /**
+     * Is the position inside the circle?  This returns exactly the
+     * same as "position - center <= radius".
+     */
+    bool contains(const SurfacePosition &position) const;
+
+    /**
+     * Same as contains(), but for a position whose unit vector is
+     * already known.
+     */
+    bool contains(const PreparedPosition &position) const;
+
+private:
+    /** the test for positions near the border, without the
+        bounding box */
+    bool containsNear(const SurfacePosition &position) const;
+};
+
 #endif
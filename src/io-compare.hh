@@ -32,47 +32,38 @@ class FindCompareReader : public RewindReader<T> {
 private:
     Find find;
     Compare compare;
-    T *reference;
+    T reference;
+    bool found;
 
 public:
     FindCompareReader(Reader<T> *_reader, Find _find, Compare _compare)
         :RewindReader<T>(_reader), find(_find), compare(_compare),
-         reference(NULL) {}
-
-    virtual ~FindCompareReader() {
-        if (reference != NULL)
-            delete reference;
-    }
+         found(false) {}
 
 public:
-    virtual const T *read() {
-        const T *t;
-
-        while (reference == NULL) {
+    virtual bool read_into(T &dest) {
+        while (!found) {
             /* find the reference item */
 
-            t = RewindReader<T>::read();
+            const T *t = this->record();
             if (t == NULL)
                 throw malformed_input("reference item not found");
 
             if (find(*t)) {
-                /* the reference has been fond: rewind the stream, so
-                   all previous objects are being compared */
-                reference = new T(*t);
+                /* the reference has been found: rewind the stream,
+                   so all previous objects are being compared */
+                reference = *t;
+                found = true;
                 this->rewind();
             }
-
-            delete t;
         }
 
-        while (true) {
-            t = RewindReader<T>::read();
-            if (t == NULL || compare(*reference, *t))
-                return t;
+        do {
+            if (!RewindReader<T>::read_into(dest))
+                return false;
+        } while (!compare(reference, dest));
 
-            /* this object didn't pass the filter: delete it */
-            delete t;
-        }
+        return true;
     }
 };
 
@@ -0,0 +1,241 @@
+/*
+ * loggertools
+ * Copyright (C) 2004-2008 Max Kellermann <max@duempel.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; version 2 of the License
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+#ifndef __LOGGERTOOLS_IO_FANOUT_HH
+#define __LOGGERTOOLS_IO_FANOUT_HH
+
+#include "io.hh"
+#include "thread.hh"
+
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * A Writer class which passes all objects to several writers.  Each
+ * writer runs in its own thread, so a slow writer does not hold back
+ * the others.  The objects are copied once into a bounded queue of
+ * batches which is shared by all writers; the producer blocks when
+ * the slowest writer is that many batches behind.
+ */
+template<class T>
+class FanOutWriter : public Writer<T> {
+private:
+    /** one batch in the queue */
+    struct Slot {
+        std::vector<T> items;
+        size_t count;
+        /** the number of writers which have not yet written this
+            batch; the slot may be reused when this is 0 */
+        unsigned pending;
+
+        Slot():count(0), pending(0) {}
+    };
+
+    class Output;
+    friend class Output;
+
+    class Output : public Thread {
+    public:
+        FanOutWriter &fan;
+        Writer<T> *writer;
+        /** the number of the next batch to be written */
+        size_t next;
+        bool failed;
+
+    public:
+        Output(FanOutWriter &_fan, Writer<T> *_writer)
+            :fan(_fan), writer(_writer), next(0), failed(false) {}
+
+        virtual ~Output() {
+            delete writer;
+        }
+
+    protected:
+        virtual void run() {
+            fan.consume(*this);
+        }
+    };
+
+    std::vector<Slot> slots;
+    std::vector<Output*> outputs;
+    Mutex mutex;
+    /** signalled when a new batch is available or the stream ends */
+    Cond available_cond;
+    /** signalled when a writer has finished a batch */
+    Cond done_cond;
+    /** the number of batches which have been queued */
+    size_t head;
+    bool finished;
+    /** the error message of the first writer which failed */
+    std::string error;
+
+public:
+    FanOutWriter(size_t queue_size)
+        :slots(queue_size), head(0), finished(false) {}
+
+    virtual ~FanOutWriter() {
+        finish();
+
+        for (typename std::vector<Output*>::iterator it = outputs.begin();
+             it != outputs.end(); ++it)
+            delete *it;
+    }
+
+private:
+    /** stop all threads after they have written the queue */
+    void finish() {
+        mutex.lock();
+        finished = true;
+        available_cond.broadcast();
+        mutex.unlock();
+
+        for (typename std::vector<Output*>::iterator it = outputs.begin();
+             it != outputs.end(); ++it)
+            (*it)->join();
+    }
+
+    void set_error(Output &output, const char *msg) {
+        ScopeLock lock(mutex);
+        output.failed = true;
+        if (error.empty())
+            error = msg;
+        done_cond.signal();
+    }
+
+    /** throw the first error of a writer thread */
+    void check_error() const {
+        if (!error.empty())
+            throw std::runtime_error(error);
+    }
+
+    /** the thread function of one writer */
+    void consume(Output &output) {
+        mutex.lock();
+
+        while (true) {
+            while (output.next == head && !finished)
+                available_cond.wait(mutex);
+
+            if (output.next == head)
+                break;
+
+            Slot &slot = slots[output.next % slots.size()];
+            bool failed = output.failed;
+            mutex.unlock();
+
+            /* after an error, the batches are still consumed, so
+               the producer is not blocked */
+            if (!failed) {
+                try {
+                    output.writer->write_batch(&slot.items[0], slot.count);
+                } catch (const std::exception &e) {
+                    set_error(output, e.what());
+                }
+            }
+
+            mutex.lock();
+            ++output.next;
+            if (--slot.pending == 0)
+                done_cond.signal();
+        }
+
+        bool failed = output.failed;
+        mutex.unlock();
+
+        if (!failed) {
+            try {
+                output.writer->flush();
+            } catch (const std::exception &e) {
+                set_error(output, e.what());
+            }
+        }
+    }
+
+public:
+    /**
+     * Add a writer and start its thread.  The FanOutWriter owns the
+     * writer from now on.  This must be called before the first
+     * object is written.
+     */
+    void add(Writer<T> *writer) {
+        Output *output = new Output(*this, writer);
+
+        if (!output->start()) {
+            delete output;
+            throw std::runtime_error("Failed to start writer thread");
+        }
+
+        outputs.push_back(output);
+    }
+
+public:
+    virtual void write(const T &t) {
+        write_batch(&t, 1);
+    }
+
+    virtual void write_batch(const T *buffer, size_t count) {
+        if (count == 0)
+            return;
+
+        mutex.lock();
+
+        Slot &slot = slots[head % slots.size()];
+        while (slot.pending > 0)
+            done_cond.wait(mutex);
+
+        if (!error.empty()) {
+            mutex.unlock();
+            check_error();
+        }
+
+        mutex.unlock();
+
+        /* no writer looks at this slot now, so it can be filled
+           without holding the lock */
+        if (slot.items.size() < count)
+            slot.items.resize(count);
+        std::copy(buffer, buffer + count, slot.items.begin());
+        slot.count = count;
+
+        mutex.lock();
+        slot.pending = outputs.size();
+        ++head;
+        available_cond.broadcast();
+        mutex.unlock();
+    }
+
+    virtual void flush() {
+        finish();
+        check_error();
+    }
+
+    virtual unsigned getFields() const {
+        unsigned fields = 0;
+
+        for (typename std::vector<Output*>::const_iterator it = outputs.begin();
+             it != outputs.end(); ++it)
+            fields |= (*it)->writer->getFields();
+
+        return fields;
+    }
+};
+
+#endif
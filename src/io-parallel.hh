@@ -0,0 +1,338 @@
+/*
+ * loggertools
+ * Copyright (C) 2004-2008 Max Kellermann <max@duempel.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; version 2 of the License
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+#ifndef __LOGGERTOOLS_IO_PARALLEL_HH
+#define __LOGGERTOOLS_IO_PARALLEL_HH
+
+#include "io.hh"
+#include "thread.hh"
+
+#include <algorithm>
+#include <deque>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * A list of inputs which can be opened independently, for
+ * ParallelReader.
+ */
+template<class T>
+class ReaderSource {
+public:
+    virtual ~ReaderSource() {}
+public:
+    virtual size_t size() const = 0;
+
+    /**
+     * Open input number i.  This is called from a worker thread, but
+     * never twice for the same input.  Throws an exception on error.
+     */
+    virtual Reader<T> *open(size_t i) = 0;
+};
+
+/**
+ * A Reader class which reads several inputs concurrently with a pool
+ * of worker threads.  It returns the objects of all inputs, either
+ * in the order of the inputs, or in the order in which they have
+ * been parsed.  Each input may only be a limited number of batches
+ * ahead of the caller.
+ *
+ * The first error of a worker is reported by read_batch() as
+ * std::runtime_error.
+ */
+template<class T>
+class ParallelReader : public Reader<T> {
+private:
+    struct Batch {
+        std::vector<T> items;
+        size_t count;
+
+        Batch(size_t size):items(size), count(0) {}
+    };
+
+    typedef std::deque<Batch*> Queue;
+
+    class Worker : public Thread {
+        ParallelReader &parallel;
+
+    public:
+        Worker(ParallelReader &_parallel):parallel(_parallel) {}
+
+    protected:
+        virtual void run() {
+            parallel.work();
+        }
+    };
+
+    friend class Worker;
+
+    ReaderSource<T> &source;
+    const size_t batch_size;
+    const bool ordered;
+    /** the maximum number of batches in a queue */
+    size_t queue_limit;
+    std::vector<Worker*> workers;
+
+    Mutex mutex;
+    /** signalled when a batch has been queued, or an input is done */
+    Cond queued_cond;
+    /** signalled when a batch has been taken from a queue */
+    Cond taken_cond;
+
+    /** the batches of each input; in unordered mode, only the
+        first queue is used */
+    std::vector<Queue> queues;
+    /** unused batches, to be reused */
+    std::vector<Batch*> unused;
+    /** the next input to be opened by a worker */
+    size_t next_input;
+    /** which inputs have been read completely, and how many */
+    std::vector<bool> done;
+    size_t num_done;
+    /** the input which is currently returned (in ordered mode) */
+    size_t current_input;
+    /** the batch which is currently returned, and the position
+        within it */
+    Batch *current;
+    size_t current_position;
+    bool quit;
+    /** the error message of the first worker which failed */
+    std::string error;
+
+public:
+    /**
+     * @param num_threads the number of worker threads; it is
+     * limited to the number of inputs
+     * @param _ordered return the objects in the order of the inputs?
+     * @param max_queued the number of batches each worker may be
+     * ahead
+     */
+    ParallelReader(ReaderSource<T> &_source, unsigned num_threads,
+                   bool _ordered, size_t _batch_size, size_t max_queued)
+        :source(_source), batch_size(_batch_size), ordered(_ordered),
+         queues(_ordered ? _source.size() : 1),
+         next_input(0), done(_source.size(), false), num_done(0),
+         current_input(0), current(NULL), current_position(0),
+         quit(false) {
+        if (num_threads > source.size())
+            num_threads = source.size();
+
+        /* in unordered mode, all workers share one queue */
+        queue_limit = ordered ? max_queued : max_queued * num_threads;
+
+        for (unsigned i = 0; i < num_threads; ++i) {
+            Worker *worker = new Worker(*this);
+            if (!worker->start()) {
+                delete worker;
+                break;
+            }
+
+            workers.push_back(worker);
+        }
+
+        if (workers.empty() && source.size() > 0)
+            throw std::runtime_error("Failed to start reader thread");
+    }
+
+    virtual ~ParallelReader() {
+        mutex.lock();
+        quit = true;
+        taken_cond.broadcast();
+        mutex.unlock();
+
+        for (typename std::vector<Worker*>::iterator it = workers.begin();
+             it != workers.end(); ++it) {
+            (*it)->join();
+            delete *it;
+        }
+
+        for (typename std::vector<Queue>::iterator q = queues.begin();
+             q != queues.end(); ++q)
+            for (typename Queue::iterator it = q->begin(); it != q->end(); ++it)
+                delete *it;
+
+        for (typename std::vector<Batch*>::iterator it = unused.begin();
+             it != unused.end(); ++it)
+            delete *it;
+
+        delete current;
+    }
+
+private:
+    /** the mutex must be locked */
+    Batch *get_batch() {
+        if (unused.empty())
+            return new Batch(batch_size);
+
+        Batch *batch = unused.back();
+        unused.pop_back();
+        return batch;
+    }
+
+    /** read one input; the mutex must be locked */
+    void read_input(size_t i) {
+        Queue &queue = queues[ordered ? i : 0];
+        Reader<T> *reader = NULL;
+
+        mutex.unlock();
+
+        try {
+            reader = source.open(i);
+        } catch (const std::exception &e) {
+            mutex.lock();
+            if (error.empty())
+                error = e.what();
+            queued_cond.signal();
+            return;
+        }
+
+        mutex.lock();
+
+        while (!quit && error.empty()) {
+            while (queue.size() >= queue_limit && !quit)
+                taken_cond.wait(mutex);
+
+            if (quit)
+                break;
+
+            /* the batch is parsed without holding the lock; no other
+               thread knows it yet */
+            Batch *batch = get_batch();
+            mutex.unlock();
+
+            try {
+                batch->count = reader->read_batch(&batch->items[0],
+                                                  batch->items.size());
+            } catch (const std::exception &e) {
+                mutex.lock();
+                unused.push_back(batch);
+                if (error.empty())
+                    error = e.what();
+                queued_cond.signal();
+                break;
+            }
+
+            mutex.lock();
+
+            if (batch->count == 0) {
+                unused.push_back(batch);
+                done[i] = true;
+                ++num_done;
+                queued_cond.signal();
+                break;
+            }
+
+            queue.push_back(batch);
+            queued_cond.signal();
+        }
+
+        mutex.unlock();
+        delete reader;
+        mutex.lock();
+    }
+
+    /** the thread function of a worker */
+    void work() {
+        ScopeLock lock(mutex);
+
+        while (!quit && error.empty() && next_input < source.size())
+            read_input(next_input++);
+    }
+
+    /**
+     * Wait for the next batch.  Returns NULL at the end of all
+     * inputs.
+     */
+    Batch *next_batch() {
+        ScopeLock lock(mutex);
+
+        while (true) {
+            if (!error.empty())
+                throw std::runtime_error(error);
+
+            if (ordered) {
+                if (current_input >= queues.size())
+                    return NULL;
+
+                Queue &queue = queues[current_input];
+                if (!queue.empty()) {
+                    Batch *batch = queue.front();
+                    queue.pop_front();
+                    taken_cond.broadcast();
+                    return batch;
+                }
+
+                if (done[current_input]) {
+                    ++current_input;
+                    continue;
+                }
+            } else {
+                Queue &queue = queues.front();
+                if (!queue.empty()) {
+                    Batch *batch = queue.front();
+                    queue.pop_front();
+                    taken_cond.broadcast();
+                    return batch;
+                }
+
+                if (num_done == source.size())
+                    return NULL;
+            }
+
+            queued_cond.wait(mutex);
+        }
+    }
+
+public:
+    virtual const T *read() {
+        T *t = new T();
+        if (read_batch(t, 1) == 0) {
+            delete t;
+            return NULL;
+        }
+
+        return t;
+    }
+
+    virtual size_t read_batch(T *buffer, size_t max_count) {
+        if (current == NULL || current_position >= current->count) {
+            if (current != NULL) {
+                ScopeLock lock(mutex);
+                unused.push_back(current);
+                current = NULL;
+            }
+
+            current = next_batch();
+            if (current == NULL)
+                return 0;
+
+            current_position = 0;
+        }
+
+        size_t n = std::min(max_count, current->count - current_position);
+        std::copy(current->items.begin() + current_position,
+                  current->items.begin() + current_position + n,
+                  buffer);
+        current_position += n;
+        return n;
+    }
+};
+
+#endif
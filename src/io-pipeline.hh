@@ -0,0 +1,243 @@
+/*
+ * loggertools
+ * Copyright (C) 2004-2008 Max Kellermann <max@duempel.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; version 2 of the License
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+#ifndef __LOGGERTOOLS_IO_PIPELINE_HH
+#define __LOGGERTOOLS_IO_PIPELINE_HH
+
+#include "io.hh"
+#include "thread.hh"
+
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <time.h>
+
+/**
+ * A Writer class which runs another writer in a separate thread, so
+ * the caller can parse the next objects while the previous ones are
+ * being formatted and written.  The two threads are connected by a
+ * lock-free single-producer/single-consumer ring of batches; only
+ * the thread which created the PipelineWriter may write to it.
+ *
+ * Errors of the writer are reported by the next write_batch() or
+ * flush() call, as std::runtime_error.
+ */
+template<class T>
+class PipelineWriter : public Writer<T> {
+private:
+    struct Slot {
+        std::vector<T> items;
+        size_t count;
+
+        Slot():count(0) {}
+    };
+
+    class Consumer : public Thread {
+        PipelineWriter &pipeline;
+
+    public:
+        Consumer(PipelineWriter &_pipeline):pipeline(_pipeline) {}
+
+    protected:
+        virtual void run() {
+            pipeline.consume();
+        }
+    };
+
+    friend class Consumer;
+
+    Writer<T> *writer;
+    std::vector<Slot> slots;
+    Consumer consumer;
+
+    /* the following variables are only accessed with atomic_load()
+       and atomic_increment() */
+
+    /** the number of batches which have been committed; only
+        modified by the producer */
+    volatile size_t head;
+    /** the number of batches which have been written; only modified
+        by the consumer */
+    volatile size_t tail;
+    /** set to 1 by the producer after the last batch */
+    volatile unsigned finished;
+    /** set to 1 by the consumer after "error" has been assigned */
+    volatile unsigned failed;
+    std::string error;
+
+public:
+    /**
+     * @param _writer the writer, which is owned by this object from
+     * now on
+     * @param batch_size the size of each batch returned by
+     * begin_batch()
+     * @param ring_size the number of batches in the ring
+     */
+    PipelineWriter(Writer<T> *_writer, size_t batch_size, size_t ring_size)
+        :writer(_writer), slots(ring_size), consumer(*this),
+         head(0), tail(0), finished(0), failed(0) {
+        for (typename std::vector<Slot>::iterator it = slots.begin();
+             it != slots.end(); ++it)
+            it->items.resize(batch_size);
+
+        if (!consumer.start()) {
+            delete writer;
+            throw std::runtime_error("Failed to start writer thread");
+        }
+    }
+
+    virtual ~PipelineWriter() {
+        finish();
+        delete writer;
+    }
+
+private:
+    /**
+     * Wait until the other thread makes progress.  Spinning is cheap
+     * while both threads are busy; when one of them stalls for a
+     * while, sleep instead of burning a CPU.
+     */
+    static void wait(unsigned &spins) {
+        if (++spins < 64) {
+            sched_yield();
+        } else {
+            struct timespec ts = { 0, 50000 };
+            nanosleep(&ts, NULL);
+        }
+    }
+
+    void finish() {
+        if (atomic_load(finished) == 0)
+            atomic_increment(finished);
+        consumer.join();
+    }
+
+    void check_error() {
+        if (atomic_load(failed) != 0)
+            throw std::runtime_error(error);
+    }
+
+    void set_error(const char *msg) {
+        error = msg;
+        atomic_increment(failed);
+    }
+
+    /** the thread function of the consumer */
+    void consume() {
+        while (true) {
+            unsigned spins = 0;
+            bool end = false;
+
+            const size_t position = atomic_load(tail);
+
+            while (position == atomic_load(head)) {
+                if (atomic_load(finished) != 0) {
+                    /* check again, a batch may have been committed
+                       just before "finished" was set */
+                    end = position == atomic_load(head);
+                    break;
+                }
+
+                wait(spins);
+            }
+
+            if (end)
+                break;
+
+            /* after an error, the batches are still consumed, so the
+               producer is not blocked */
+            if (atomic_load(failed) == 0) {
+                Slot &slot = slots[position % slots.size()];
+                try {
+                    writer->write_batch(&slot.items[0], slot.count);
+                } catch (const std::exception &e) {
+                    set_error(e.what());
+                }
+            }
+
+            atomic_increment(tail);
+        }
+
+        if (atomic_load(failed) == 0) {
+            try {
+                writer->flush();
+            } catch (const std::exception &e) {
+                set_error(e.what());
+            }
+        }
+    }
+
+public:
+    /**
+     * Returns a buffer which the caller may fill with up to
+     * batch_size objects, and then pass to commit_batch().  This
+     * avoids the copy done by write_batch().  It blocks while the
+     * ring is full.
+     */
+    T *begin_batch() {
+        unsigned spins = 0;
+        const size_t position = atomic_load(head);
+
+        while (position - atomic_load(tail) >= slots.size()) {
+            check_error();
+            wait(spins);
+        }
+
+        check_error();
+        return &slots[position % slots.size()].items[0];
+    }
+
+    /**
+     * Pass the batch returned by begin_batch() to the writer thread.
+     */
+    void commit_batch(size_t count) {
+        slots[atomic_load(head) % slots.size()].count = count;
+        atomic_increment(head);
+    }
+
+public:
+    virtual void write(const T &t) {
+        write_batch(&t, 1);
+    }
+
+    virtual void write_batch(const T *buffer, size_t count) {
+        const size_t batch_size = slots.front().items.size();
+
+        while (count > 0) {
+            size_t n = std::min(count, batch_size);
+            std::copy(buffer, buffer + n, begin_batch());
+            commit_batch(n);
+            buffer += n;
+            count -= n;
+        }
+    }
+
+    virtual void flush() {
+        finish();
+        check_error();
+    }
+
+    virtual unsigned getFields() const {
+        return writer->getFields();
+    }
+};
+
+#endif
@@ -0,0 +1,146 @@
+/*
+ * loggertools
+ * Copyright (C) 2004-2008 Max Kellermann <max@duempel.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; version 2 of the License
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef __LOGGERTOOLS_IO_PREDICATE_HH
+#define __LOGGERTOOLS_IO_PREDICATE_HH
+
+#include "io.hh"
+
+#include <algorithm>
+#include <vector>
+
+/**
+ * A combination of predicates, all of which must match.  They are
+ * checked in the order of their cost, so a cheap test rejects an
+ * object before the expensive ones are done.
+ */
+template<class T>
+class PredicateList : public Predicate<T> {
+private:
+    typedef std::vector<Predicate<T>*> List;
+    List predicates;
+
+    static bool compare_cost(const Predicate<T> *a, const Predicate<T> *b) {
+        return a->getCost() < b->getCost();
+    }
+
+public:
+    virtual ~PredicateList() {
+        for (typename List::iterator it = predicates.begin();
+             it != predicates.end(); ++it)
+            delete *it;
+    }
+
+public:
+    bool empty() const {
+        return predicates.empty();
+    }
+
+    size_t size() const {
+        return predicates.size();
+    }
+
+    const Predicate<T> &operator [](size_t i) const {
+        return *predicates[i];
+    }
+
+    /** add a predicate; the list owns it from now on */
+    void add(Predicate<T> *predicate) {
+        predicates.insert(std::upper_bound(predicates.begin(),
+                                           predicates.end(), predicate,
+                                           compare_cost),
+                          predicate);
+    }
+
+public:
+    virtual unsigned getCost() const {
+        unsigned cost = 0;
+
+        for (typename List::const_iterator it = predicates.begin();
+             it != predicates.end(); ++it)
+            cost += (*it)->getCost();
+
+        return cost;
+    }
+
+    virtual bool match(const T &t) const {
+        for (typename List::const_iterator it = predicates.begin();
+             it != predicates.end(); ++it)
+            if (!(*it)->match(t))
+                return false;
+
+        return true;
+    }
+};
+
+/**
+ * A Reader class which returns all objects matching a predicate.  It
+ * is used for readers which cannot check the predicate themselves.
+ */
+template<class T>
+class PredicateReader : public Reader<T> {
+private:
+    Reader<T> *reader;
+    Predicate<T> *predicate;
+
+public:
+    PredicateReader(Reader<T> *_reader, Predicate<T> *_predicate)
+        :reader(_reader), predicate(_predicate) {}
+
+    virtual ~PredicateReader() {
+        delete predicate;
+        delete reader;
+    }
+
+public:
+    virtual const T *read() {
+        while (true) {
+            const T *t = reader->read();
+            if (t == NULL || predicate->match(*t))
+                return t;
+
+            /* this object didn't pass the filter: delete it */
+            delete t;
+        }
+    }
+
+    virtual size_t read_batch(T *buffer, size_t max_count) {
+        while (true) {
+            size_t count = reader->read_batch(buffer, max_count), n = 0;
+            if (count == 0)
+                return 0;
+
+            /* move matching objects to the front; swapping instead
+               of assigning keeps the memory of all objects in the
+               buffer */
+            for (size_t i = 0; i < count; ++i) {
+                if (predicate->match(buffer[i])) {
+                    if (i != n)
+                        std::swap(buffer[n], buffer[i]);
+                    ++n;
+                }
+            }
+
+            if (n > 0)
+                return n;
+        }
+    }
+};
+
+#endif
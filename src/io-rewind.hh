@@ -22,50 +22,97 @@
 
 #include "io.hh"
 
-#include <list>
+#include <algorithm>
+#include <vector>
 
 /**
- * A Reader class which lets the caller rewind the stream, by saving a
- * copy of all objects.
+ * A Reader class which lets the caller rewind the stream.  Objects
+ * are recorded with record() into a buffer, which is returned by
+ * read_into() after rewind().  The buffer consists of fixed-size
+ * arrays, so growing it never moves objects, and the buffered
+ * objects are moved out by swapping, not copied.
  */
 template<class T>
-class RewindReader : public Reader<T> {
+class RewindReader : public RecordReader<T> {
 private:
+    /** the number of objects in one array of the buffer */
+    static const size_t BLOCK_SIZE = 1024;
+
     Reader<T> *reader;
-    std::list<T> buffer;
-    bool from_buffer;
+    std::vector<T*> blocks;
+    /** the number of recorded objects */
+    size_t count;
+    /** the next buffered object to be returned by read_into() */
+    size_t position;
+    bool rewound;
 
 public:
     RewindReader(Reader<T> *_reader)
-        :reader(_reader), buffer(), from_buffer(false) {}
+        :reader(_reader), count(0), position(0), rewound(false) {}
 
     virtual ~RewindReader() {
+        clear();
         delete reader;
     }
 
+private:
+    T &at(size_t i) {
+        return blocks[i / BLOCK_SIZE][i % BLOCK_SIZE];
+    }
+
+    void clear() {
+        for (size_t i = 0; i < blocks.size(); ++i)
+            delete[] blocks[i];
+        blocks.clear();
+        count = position = 0;
+    }
+
 public:
-    virtual const T *read() {
-        if (from_buffer) {
-            /* rewind() has been called; get the next object from the
-               buffer */
-            const T *ret = new T(*buffer.begin());
-            buffer.pop_front();
-            if (buffer.empty())
-                from_buffer = false;
-            return ret;
-        }
+    /**
+     * Read the next object from the stream into the buffer, without
+     * returning it from read_into().  Returns NULL at the end of the
+     * stream.  The pointer is valid until the next call.  This must
+     * not be called after rewind().
+     */
+    const T *record() {
+        if (count == blocks.size() * BLOCK_SIZE)
+            blocks.push_back(new T[BLOCK_SIZE]);
 
-        const T *t = reader->read();
-        if (t != NULL)
-            /* save the object, just in case the caller wants to
-               rewind */
-            buffer.push_back(*t);
-        return t;
+        T &t = at(count);
+        if (reader->read_batch(&t, 1) == 0)
+            return NULL;
+
+        ++count;
+        return &t;
     }
 
+    /**
+     * Let read_into() return all recorded objects, before it
+     * continues with the stream.
+     */
     void rewind() {
-        if (!buffer.empty())
-            from_buffer = true;
+        rewound = true;
+        position = 0;
+    }
+
+    virtual bool read_into(T &dest) {
+        if (rewound && position < count) {
+            std::swap(dest, at(position));
+            ++position;
+
+            if (position == count)
+                /* all recorded objects have been returned */
+                clear();
+            else if (position % BLOCK_SIZE == 0) {
+                /* free the memory of this array early */
+                delete[] blocks[position / BLOCK_SIZE - 1];
+                blocks[position / BLOCK_SIZE - 1] = NULL;
+            }
+
+            return true;
+        }
+
+        return reader->read_batch(&dest, 1) > 0;
     }
 };
 
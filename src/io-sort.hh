@@ -0,0 +1,328 @@
+/*
+ * loggertools
+ * Copyright (C) 2004-2008 Max Kellermann <max@duempel.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; version 2 of the License
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef __LOGGERTOOLS_IO_SORT_HH
+#define __LOGGERTOOLS_IO_SORT_HH
+
+#include "io.hh"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+
+/**
+ * Sorts any number of objects with a bounded amount of memory (an
+ * external merge sort).  The objects are collected in memory until
+ * their estimated size exceeds the limit; then this run is sorted
+ * and written to a temporary file.  In the end, the runs are merged
+ * with a heap, which keeps only one object of each run in memory.
+ * Objects which compare equal keep the order in which they were
+ * added.
+ *
+ * The Order class provides "uint64_t key(const T&)", which is
+ * compared first, and "bool less(const T&, const T&)", which is only
+ * called for equal keys.  The Codec class provides "static size_t
+ * getSize(const T&)" (the estimated memory usage), "static void
+ * write(FILE*, const T&)" and "static bool read(FILE*, T&)" (false
+ * at the end of the file).
+ */
+template<class T, class Order, class Codec>
+class ExternalSorter {
+private:
+    struct Entry {
+        uint64_t key;
+        size_t index;
+    };
+
+    class EntryCompare {
+        const Order &order;
+        const std::vector<T> &items;
+
+    public:
+        EntryCompare(const Order &_order, const std::vector<T> &_items)
+            :order(_order), items(_items) {}
+
+        bool operator ()(const Entry &a, const Entry &b) const {
+            if (a.key != b.key)
+                return a.key < b.key;
+            if (order.less(items[a.index], items[b.index]))
+                return true;
+            if (order.less(items[b.index], items[a.index]))
+                return false;
+            return a.index < b.index;
+        }
+    };
+
+    struct Run {
+        FILE *file;
+        T head;
+        uint64_t key;
+    };
+
+    /**
+     * The heap comparison: the run with the smallest head (and, if
+     * they are equal, the older run) is at the top.
+     */
+    class RunCompare {
+        const Order &order;
+        const std::vector<Run> &runs;
+
+    public:
+        RunCompare(const Order &_order, const std::vector<Run> &_runs)
+            :order(_order), runs(_runs) {}
+
+        bool operator ()(size_t a, size_t b) const {
+            const Run &x = runs[a], &y = runs[b];
+            if (x.key != y.key)
+                return x.key > y.key;
+            if (order.less(y.head, x.head))
+                return true;
+            if (order.less(x.head, y.head))
+                return false;
+            return a > b;
+        }
+    };
+
+    Order order;
+    size_t memory_limit, memory_used;
+
+    /** the current run */
+    std::vector<T> items;
+    size_t num_items;
+    std::vector<Entry> entries;
+    size_t position;
+
+    /** the runs which have been written to temporary files */
+    std::vector<Run> runs;
+    /** the runs which are not empty yet, as a heap */
+    std::vector<size_t> heap;
+
+    bool finished;
+
+public:
+    /**
+     * @param memory_limit the estimated number of bytes which may be
+     * used for sorting
+     */
+    ExternalSorter(const Order &_order, size_t _memory_limit)
+        :order(_order), memory_limit(_memory_limit), memory_used(0),
+         num_items(0), position(0), finished(false) {}
+
+    ~ExternalSorter() {
+        for (typename std::vector<Run>::iterator it = runs.begin();
+             it != runs.end(); ++it)
+            fclose(it->file);
+    }
+
+private:
+    /* no copying */
+    ExternalSorter(const ExternalSorter &);
+    ExternalSorter &operator =(const ExternalSorter &);
+
+    void sortRun() {
+        entries.resize(num_items);
+        for (size_t i = 0; i < num_items; ++i) {
+            entries[i].key = order.key(items[i]);
+            entries[i].index = i;
+        }
+
+        std::sort(entries.begin(), entries.end(),
+                  EntryCompare(order, items));
+        position = 0;
+    }
+
+    void writeRun() {
+        Run run;
+
+        run.file = tmpfile();
+        if (run.file == NULL)
+            throw std::runtime_error(std::string("Failed to create temporary file: ") +
+                                     strerror(errno));
+
+        for (typename std::vector<Entry>::const_iterator it = entries.begin();
+             it != entries.end(); ++it)
+            Codec::write(run.file, items[it->index]);
+
+        if (fflush(run.file) != 0 || ferror(run.file)) {
+            int e = errno;
+            fclose(run.file);
+            throw std::runtime_error(std::string("Failed to write temporary file: ") +
+                                     strerror(e));
+        }
+
+        run.key = 0;
+        runs.push_back(run);
+
+        /* the objects are kept (and overwritten by the next run), so
+           their memory can be reused */
+        num_items = 0;
+        entries.clear();
+        memory_used = 0;
+    }
+
+    bool readRun(Run &run) {
+        if (!Codec::read(run.file, run.head))
+            return false;
+
+        run.key = order.key(run.head);
+        return true;
+    }
+
+public:
+    /**
+     * Returns a buffer for up to "count" objects, which may contain
+     * old values.  Call commit_add() after the objects have been
+     * filled.
+     */
+    T *begin_add(size_t count) {
+        if (items.size() < num_items + count)
+            items.resize(num_items + count);
+        return &items[num_items];
+    }
+
+    void commit_add(size_t count) {
+        for (size_t i = num_items; i < num_items + count; ++i)
+            memory_used += Codec::getSize(items[i]) + sizeof(Entry);
+        num_items += count;
+
+        if (memory_used >= memory_limit) {
+            sortRun();
+            writeRun();
+        }
+    }
+
+    /**
+     * Call this after the last object has been added.
+     */
+    void finish() {
+        if (runs.empty()) {
+            /* everything fits into memory */
+            sortRun();
+        } else {
+            if (num_items > 0) {
+                sortRun();
+                writeRun();
+            }
+
+            items.clear();
+
+            for (size_t i = 0; i < runs.size(); ++i) {
+                rewind(runs[i].file);
+                if (readRun(runs[i]))
+                    heap.push_back(i);
+            }
+
+            std::make_heap(heap.begin(), heap.end(),
+                           RunCompare(order, runs));
+        }
+
+        finished = true;
+    }
+
+    bool isFinished() const {
+        return finished;
+    }
+
+    /**
+     * Copy the next object in sorted order to dest.
+     *
+     * @return false when all objects have been returned
+     */
+    bool next(T &dest) {
+        if (runs.empty()) {
+            if (position >= entries.size())
+                return false;
+
+            dest = items[entries[position++].index];
+            return true;
+        }
+
+        if (heap.empty())
+            return false;
+
+        const RunCompare compare(order, runs);
+        std::pop_heap(heap.begin(), heap.end(), compare);
+
+        Run &run = runs[heap.back()];
+        dest = run.head;
+
+        if (readRun(run))
+            std::push_heap(heap.begin(), heap.end(), compare);
+        else
+            heap.pop_back();
+
+        return true;
+    }
+};
+
+/**
+ * A reader which returns the objects of another reader in sorted
+ * order, see ExternalSorter.
+ */
+template<class T, class Order, class Codec>
+class SortReader : public RecordReader<T> {
+private:
+    /** the number of objects loaded with one read_batch() call */
+    static const size_t LOAD_BATCH = 1024;
+
+    Reader<T> *reader;
+    ExternalSorter<T, Order, Codec> sorter;
+
+public:
+    /**
+     * @param reader the input, which is deleted by this object
+     */
+    SortReader(Reader<T> *_reader, const Order &order,
+               size_t memory_limit)
+        :reader(_reader), sorter(order, memory_limit) {}
+
+    virtual ~SortReader() {
+        delete reader;
+    }
+
+private:
+    void load() {
+        size_t count;
+
+        while ((count = reader->read_batch(sorter.begin_add(LOAD_BATCH),
+                                           LOAD_BATCH)) > 0)
+            sorter.commit_add(count);
+
+        delete reader;
+        reader = NULL;
+
+        sorter.finish();
+    }
+
+public:
+    virtual bool read_into(T &dest) {
+        if (!sorter.isFinished())
+            load();
+
+        return sorter.next(dest);
+    }
+};
+
+#endif
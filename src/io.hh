@@ -22,12 +22,124 @@
 
 #include <iosfwd>
 
+#include <stddef.h>
+
+/**
+ * A condition which objects must fulfil.  Unlike filtering readers,
+ * predicates can be combined and checked in one pass, and readers
+ * may check them before they return an object.  match() must not
+ * modify the predicate, because it may be called from several
+ * threads.
+ */
+template<class T>
+class Predicate {
+public:
+    virtual ~Predicate() {}
+public:
+    /**
+     * A rough estimate of the cost of match(), for checking cheap
+     * predicates first: 1 for comparing a field, 2 for a geometric
+     * test, 3 for string comparisons.
+     */
+    virtual unsigned getCost() const = 0;
+
+    virtual bool match(const T &t) const = 0;
+};
+
 template<class T>
 class Reader {
 public:
     virtual ~Reader() {}
 public:
     virtual const T *read() = 0;
+
+    /**
+     * Ask the reader to return only objects matching the predicate;
+     * it may be able to skip the others before they are completely
+     * built.  This must be called before the first object is read.
+     * On success, the reader owns the predicate.
+     *
+     * @return false if the reader does not support this
+     */
+    virtual bool setPredicate(Predicate<T> *predicate) {
+        (void)predicate;
+        return false;
+    }
+
+    /**
+     * Tell the reader which fields of the objects are going to be
+     * used (a bit mask, see T::FIELD_*).  It may skip parsing the
+     * others and leave them empty.  This must be called before the
+     * first object is read, and the mask must include the fields
+     * which the predicate looks at.
+     */
+    virtual void setFields(unsigned fields) {
+        (void)fields;
+    }
+
+    /**
+     * Read up to max_count objects into a buffer owned by the
+     * caller.  The objects in the buffer are overwritten, which
+     * allows them to reuse their memory from the previous call.
+     *
+     * The default implementation copies the results of read();
+     * readers which can parse directly into the buffer should
+     * override this method.
+     *
+     * @return the number of objects read, 0 at the end of the stream
+     */
+    virtual size_t read_batch(T *buffer, size_t max_count) {
+        size_t n;
+
+        for (n = 0; n < max_count; ++n) {
+            const T *t = read();
+            if (t == NULL)
+                break;
+
+            buffer[n] = *t;
+            delete t;
+        }
+
+        return n;
+    }
+};
+
+/**
+ * Base class for readers which parse each object into a
+ * caller-provided instance.  Implementations only provide
+ * read_into(), and get read() and read_batch() for free.
+ */
+template<class T>
+class RecordReader : public Reader<T> {
+public:
+    /**
+     * Parse the next object into dest.  dest may still contain the
+     * values of an older object, which must be overwritten or
+     * cleared.
+     *
+     * @return false at the end of the stream
+     */
+    virtual bool read_into(T &dest) = 0;
+
+    virtual const T *read() {
+        T *t = new T();
+        if (!read_into(*t)) {
+            delete t;
+            return NULL;
+        }
+
+        return t;
+    }
+
+    virtual size_t read_batch(T *buffer, size_t max_count) {
+        size_t n;
+
+        for (n = 0; n < max_count; ++n)
+            if (!read_into(buffer[n]))
+                break;
+
+        return n;
+    }
 };
 
 template<class T>
@@ -36,7 +148,25 @@ public:
     virtual ~Writer() {}
 public:
     virtual void write(const T &tp) = 0;
+
+    /**
+     * Write a number of objects.  The default implementation calls
+     * write() for each of them.
+     */
+    virtual void write_batch(const T *buffer, size_t count) {
+        for (size_t i = 0; i < count; ++i)
+            write(buffer[i]);
+    }
+
     virtual void flush() = 0;
+
+    /**
+     * Which fields of the objects does this writer use?  Returns a
+     * bit mask, see T::FIELD_*.
+     */
+    virtual unsigned getFields() const {
+        return ~0u;
+    }
 };
 
 template<class T>
@@ -46,6 +176,16 @@ public:
 public:
     virtual Reader<T> *createReader(std::istream *stream) const = 0;
     virtual Writer<T> *createWriter(std::ostream *stream) const = 0;
+
+    /**
+     * Create a reader which accesses the file directly, e.g. by
+     * mapping it into memory.  Returns NULL if the format does not
+     * support this; the caller should use createReader() then.
+     */
+    virtual Reader<T> *createFileReader(const char *path) const {
+        (void)path;
+        return NULL;
+    }
 };
 
 template<class T>
@@ -55,6 +195,25 @@ public:
 public:
     virtual Reader<T> *createFilter(Reader<T> *reader,
                                     const char *args) const = 0;
+
+    /**
+     * Create a predicate which does the same as createFilter(), so it
+     * can be combined with others.  Returns NULL if the filter
+     * depends on the stream, e.g. because it looks for a reference
+     * object.
+     */
+    virtual Predicate<T> *createPredicate(const char *args) const {
+        (void)args;
+        return NULL;
+    }
+
+    /**
+     * Which fields of the objects does this filter look at?  Returns
+     * a bit mask, see T::FIELD_*.
+     */
+    virtual unsigned getFields() const {
+        return ~0u;
+    }
 };
 
 #endif
@@ -0,0 +1,85 @@
+/*
+ * loggertools
+ * Copyright (C) 2004-2008 Max Kellermann <max@duempel.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; version 2 of the License
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include "mapped-file.hh"
+
+#include <stdexcept>
+#include <string>
+
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+static void
+throw_errno(const char *msg, const char *path)
+{
+    throw std::runtime_error(std::string(msg) + " " + path + ": " +
+                             strerror(errno));
+}
+
+MappedFile::MappedFile(const char *path)
+    :data(NULL), size(0) {
+    int fd;
+    struct stat st;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0)
+        throw_errno("Failed to open", path);
+
+    if (fstat(fd, &st) < 0) {
+        int e = errno;
+        close(fd);
+        errno = e;
+        throw_errno("Failed to stat", path);
+    }
+
+    size = (size_t)st.st_size;
+
+    /* an empty file cannot be mapped; data stays NULL then */
+    if (size > 0) {
+        data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            int e = errno;
+            close(fd);
+            data = NULL;
+            errno = e;
+            throw_errno("Failed to map", path);
+        }
+
+        madvise(data, size, MADV_SEQUENTIAL);
+    }
+
+    close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (data != NULL)
+        munmap(data, size);
+}
+
+bool
+MappedFile::isMappable(const char *path)
+{
+    struct stat st;
+
+    return stat(path, &st) == 0 && S_ISREG(st.st_mode);
+}
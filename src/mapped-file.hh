@@ -0,0 +1,66 @@
+/*
+ * loggertools
+ * Copyright (C) 2004-2008 Max Kellermann <max@duempel.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; version 2 of the License
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef __LOGGERTOOLS_MAPPED_FILE_HH
+#define __LOGGERTOOLS_MAPPED_FILE_HH
+
+#include <stddef.h>
+
+/**
+ * A regular file which is mapped read-only into memory.
+ */
+class MappedFile {
+private:
+    void *data;
+    size_t size;
+
+public:
+    /**
+     * Map the specified file.  Throws std::runtime_error if the file
+     * cannot be opened or mapped.
+     */
+    MappedFile(const char *path);
+    ~MappedFile();
+
+private:
+    /* no copying */
+    MappedFile(const MappedFile &);
+    MappedFile &operator =(const MappedFile &);
+
+public:
+    /**
+     * Checks whether the file is a regular file, i.e. whether it can
+     * be mapped into memory at all.
+     */
+    static bool isMappable(const char *path);
+
+    const char *begin() const {
+        return (const char*)data;
+    }
+
+    const char *end() const {
+        return begin() + size;
+    }
+
+    size_t getSize() const {
+        return size;
+    }
+};
+
+#endif
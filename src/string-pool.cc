@@ -0,0 +1,145 @@
+/*
+ * loggertools
+ * Copyright (C) 2004-2008 Max Kellermann <max@duempel.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; version 2 of the License
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include "string-pool.hh"
+
+#include <string.h>
+
+/** the size of the memory blocks; longer strings get their own */
+static const size_t BLOCK_SIZE = 64 * 1024;
+
+/** FNV-1a */
+static uint32_t
+hash_string(const char *value, size_t length)
+{
+    uint32_t hash = 2166136261u;
+
+    for (size_t i = 0; i < length; ++i)
+        hash = (hash ^ (unsigned char)value[i]) * 16777619u;
+
+    return hash;
+}
+
+StringPool::StringPool()
+    :free_begin(NULL), free_end(NULL)
+{
+    Slot free_slot;
+    free_slot.hash = 0;
+    free_slot.handle = 0;
+    table.resize(64, free_slot);
+
+    Entry empty;
+    empty.data = "";
+    empty.length = 0;
+    entries.push_back(empty);
+}
+
+StringPool::~StringPool()
+{
+    for (std::vector<char *>::iterator it = blocks.begin();
+         it != blocks.end(); ++it)
+        delete[] *it;
+}
+
+char *
+StringPool::allocate(size_t size)
+{
+    if (size > BLOCK_SIZE / 4) {
+        /* insert it before the last block, which still has free
+           space */
+        char *p = new char[size];
+        blocks.insert(blocks.end() - (blocks.empty() ? 0 : 1), p);
+        return p;
+    }
+
+    if ((size_t)(free_end - free_begin) < size) {
+        char *block = new char[BLOCK_SIZE];
+        blocks.push_back(block);
+        free_begin = block;
+        free_end = block + BLOCK_SIZE;
+    }
+
+    char *p = free_begin;
+    free_begin += size;
+    return p;
+}
+
+void
+StringPool::grow()
+{
+    Slot free_slot;
+    free_slot.hash = 0;
+    free_slot.handle = 0;
+
+    std::vector<Slot> new_table(table.size() * 2, free_slot);
+    const size_t mask = new_table.size() - 1;
+
+    for (std::vector<Slot>::const_iterator it = table.begin();
+         it != table.end(); ++it) {
+        if (it->handle == 0)
+            continue;
+
+        size_t i = it->hash & mask;
+        while (new_table[i].handle != 0)
+            i = (i + 1) & mask;
+        new_table[i] = *it;
+    }
+
+    table.swap(new_table);
+}
+
+StringPool::handle_t
+StringPool::intern(const char *value, size_t length)
+{
+    if (length == 0)
+        return EMPTY;
+
+    const uint32_t hash = hash_string(value, length);
+    const size_t mask = table.size() - 1;
+
+    size_t i;
+    for (i = hash & mask; table[i].handle != 0; i = (i + 1) & mask) {
+        if (table[i].hash != hash)
+            continue;
+
+        const Entry &entry = entries[table[i].handle];
+        if (entry.length == length &&
+            memcmp(entry.data, value, length) == 0)
+            return table[i].handle;
+    }
+
+    char *data = allocate(length + 1);
+    memcpy(data, value, length);
+    data[length] = 0;
+
+    Entry entry;
+    entry.data = data;
+    entry.length = length;
+
+    const handle_t handle = (handle_t)entries.size();
+    entries.push_back(entry);
+    table[i].hash = hash;
+    table[i].handle = handle;
+
+    /* keep the table at most half full */
+    if (entries.size() * 2 > table.size())
+        grow();
+
+    return handle;
+}
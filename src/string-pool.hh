@@ -0,0 +1,106 @@
+/*
+ * loggertools
+ * Copyright (C) 2004-2008 Max Kellermann <max@duempel.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; version 2 of the License
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef __LOGGERTOOLS_STRING_POOL_HH
+#define __LOGGERTOOLS_STRING_POOL_HH
+
+#include <string>
+#include <vector>
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Stores each distinct string only once, in large blocks of memory
+ * which are freed together with the pool.  The strings are referred
+ * to by small handles; they are null-terminated, and their
+ * addresses never change.
+ */
+class StringPool {
+public:
+    typedef uint32_t handle_t;
+
+    /** the handle of the empty string */
+    static const handle_t EMPTY = 0;
+
+private:
+    struct Entry {
+        const char *data;
+        size_t length;
+    };
+
+    std::vector<char *> blocks;
+    /** the free space in the last block */
+    char *free_begin, *free_end;
+
+    std::vector<Entry> entries;
+
+    /** a slot of the hash table; with the hash, most mismatches
+        don't need to look at the entry */
+    struct Slot {
+        uint32_t hash;
+        handle_t handle;
+    };
+
+    /** an open addressing hash table; handle 0 marks free slots */
+    std::vector<Slot> table;
+
+public:
+    StringPool();
+    ~StringPool();
+
+private:
+    /* no copying */
+    StringPool(const StringPool &);
+    StringPool &operator =(const StringPool &);
+
+    char *allocate(size_t size);
+    void grow();
+
+public:
+    /**
+     * Return the handle of the string, and copy it into the pool if
+     * it is not there yet.
+     */
+    handle_t intern(const char *value, size_t length);
+
+    handle_t intern(const std::string &value) {
+        return intern(value.data(), value.length());
+    }
+
+    const char *get(handle_t handle) const {
+        return entries[handle].data;
+    }
+
+    size_t getLength(handle_t handle) const {
+        return entries[handle].length;
+    }
+
+    void get(handle_t handle, std::string &dest) const {
+        const Entry &entry = entries[handle];
+        dest.assign(entry.data, entry.length);
+    }
+
+    /** the number of distinct strings (including the empty one) */
+    size_t size() const {
+        return entries.size();
+    }
+};
+
+#endif
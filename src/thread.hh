@@ -0,0 +1,184 @@
+/*
+ * loggertools
+ * Copyright (C) 2004-2008 Max Kellermann <max@duempel.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; version 2 of the License
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef __LOGGERTOOLS_THREAD_HH
+#define __LOGGERTOOLS_THREAD_HH
+
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+/**
+ * Thin wrappers around the pthread primitives.
+ */
+
+class Mutex {
+    friend class Cond;
+
+private:
+    pthread_mutex_t mutex;
+
+public:
+    Mutex() {
+        pthread_mutex_init(&mutex, NULL);
+    }
+
+    ~Mutex() {
+        pthread_mutex_destroy(&mutex);
+    }
+
+private:
+    /* no copying */
+    Mutex(const Mutex &);
+    Mutex &operator =(const Mutex &);
+
+public:
+    void lock() {
+        pthread_mutex_lock(&mutex);
+    }
+
+    void unlock() {
+        pthread_mutex_unlock(&mutex);
+    }
+};
+
+/**
+ * Locks a mutex for the lifetime of this object.
+ */
+class ScopeLock {
+private:
+    Mutex &mutex;
+
+public:
+    ScopeLock(Mutex &_mutex)
+        :mutex(_mutex) {
+        mutex.lock();
+    }
+
+    ~ScopeLock() {
+        mutex.unlock();
+    }
+
+private:
+    ScopeLock(const ScopeLock &);
+    ScopeLock &operator =(const ScopeLock &);
+};
+
+class Cond {
+private:
+    pthread_cond_t cond;
+
+public:
+    Cond() {
+        pthread_cond_init(&cond, NULL);
+    }
+
+    ~Cond() {
+        pthread_cond_destroy(&cond);
+    }
+
+private:
+    Cond(const Cond &);
+    Cond &operator =(const Cond &);
+
+public:
+    /** the mutex must be locked by the caller */
+    void wait(Mutex &mutex) {
+        pthread_cond_wait(&cond, &mutex.mutex);
+    }
+
+    void signal() {
+        pthread_cond_signal(&cond);
+    }
+
+    void broadcast() {
+        pthread_cond_broadcast(&cond);
+    }
+};
+
+/**
+ * Atomic operations on a variable which is shared between threads
+ * without a lock.  Both are full memory barriers: no other load or
+ * store is moved across them.
+ */
+template<class T>
+static inline T
+atomic_load(volatile T &value)
+{
+    return __sync_fetch_and_add(&value, 0);
+}
+
+template<class T>
+static inline void
+atomic_increment(volatile T &value)
+{
+    __sync_fetch_and_add(&value, 1);
+}
+
+/**
+ * A thread which runs the virtual method run().  The owner must call
+ * join() before the object is destroyed.
+ */
+class Thread {
+private:
+    pthread_t thread;
+    bool running;
+
+public:
+    Thread():running(false) {}
+    virtual ~Thread() {}
+
+private:
+    Thread(const Thread &);
+    Thread &operator =(const Thread &);
+
+    static void *run_thread(void *arg) {
+        ((Thread*)arg)->run();
+        return NULL;
+    }
+
+protected:
+    virtual void run() = 0;
+
+public:
+    /**
+     * Start the thread.  Returns false if that fails.
+     */
+    bool start() {
+        running = pthread_create(&thread, NULL, run_thread, this) == 0;
+        return running;
+    }
+
+    void join() {
+        if (running) {
+            pthread_join(thread, NULL);
+            running = false;
+        }
+    }
+
+    /**
+     * Returns the number of processors which are online.
+     */
+    static unsigned countProcessors() {
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+        return n > 0 ? (unsigned)n : 1;
+    }
+};
+
+#endif
@@ -20,61 +20,49 @@
 #include "exception.hh"
 #include "tp.hh"
 #include "tp-io.hh"
-#include "earth-parser.hh"
+#include "tp-constraint.hh"
+#include "io-predicate.hh"
 
-class AirfieldTurnPointReader : public TurnPointReader {
-private:
-    TurnPointReader *reader;
+class AirfieldTurnPointPredicate : public TurnPointPredicate {
 public:
-    AirfieldTurnPointReader(TurnPointReader *_reader)
-        :reader(_reader) {}
-    virtual ~AirfieldTurnPointReader();
-public:
-    virtual const TurnPoint *read();
+    virtual unsigned getCost() const {
+        return 1;
+    }
+
+    virtual bool match(const TurnPoint &tp) const {
+        return TurnPoint::isAirfield(tp.getType());
+    }
+
+    virtual bool constrain(TurnPointConstraint &constraint) const {
+        unsigned long mask = 0;
+
+        for (unsigned type = 0; type <= TurnPoint::TYPE_THERMALS; ++type)
+            if (TurnPoint::isAirfield((TurnPoint::type_t)type))
+                mask |= 1ul << type;
+
+        constraint.restrictTypes(mask);
+        return true;
+    }
 };
 
-TurnPointReader *
-AirfieldTurnPointFilter::createFilter(TurnPointReader *reader,
-                                      const char *args) const
+TurnPointPredicate *
+AirfieldTurnPointFilter::createPredicate(const char *args) const
 {
     if (args != NULL && *args != 0)
         throw malformed_input("No arguments supported");
 
-    return new AirfieldTurnPointReader(reader);
+    return new AirfieldTurnPointPredicate();
 }
 
-AirfieldTurnPointReader::~AirfieldTurnPointReader()
+unsigned
+AirfieldTurnPointFilter::getFields() const
 {
-    if (reader != NULL)
-        delete reader;
+    return TurnPoint::FIELD_TYPE;
 }
 
-static bool
-is_airfield(TurnPoint::type_t type)
-{
-    return type == TurnPoint::TYPE_AIRFIELD ||
-        type == TurnPoint::TYPE_MILITARY_AIRFIELD ||
-        type == TurnPoint::TYPE_GLIDER_SITE ||
-        type == TurnPoint::TYPE_ULTRALIGHT_FIELD ||
-        type == TurnPoint::TYPE_OUTLANDING;
-}
-
-const TurnPoint *
-AirfieldTurnPointReader::read()
+TurnPointReader *
+AirfieldTurnPointFilter::createFilter(TurnPointReader *reader,
+                                      const char *args) const
 {
-    const TurnPoint *tp;
-
-    if (reader == NULL)
-        return NULL;
-
-    while ((tp = reader->read()) != NULL) {
-        if (is_airfield(tp->getType()))
-            return tp;
-        else
-            delete tp;
-    }
-
-    delete reader;
-    reader = NULL;
-    return NULL;
+    return new PredicateReader<TurnPoint>(reader, createPredicate(args));
 }
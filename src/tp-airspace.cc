@@ -0,0 +1,177 @@
+/*
+ * loggertools
+ * Copyright (C) 2004-2008 Max Kellermann <max@duempel.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; version 2 of the License
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include "exception.hh"
+#include "tp.hh"
+#include "tp-io.hh"
+#include "airspace-io.hh"
+#include "airspace-index.hh"
+#include "io-predicate.hh"
+
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#include <string.h>
+
+/**
+ * Matches turn points which are inside (or outside) one of the
+ * airspaces in an AirspaceIndex.
+ */
+class AirspaceTurnPointPredicate : public TurnPointPredicate {
+    AirspaceIndex index;
+    bool inside;
+
+public:
+    AirspaceTurnPointPredicate(bool _inside)
+        :inside(_inside) {}
+
+public:
+    AirspaceIndex &getIndex() {
+        return index;
+    }
+
+    virtual unsigned getCost() const {
+        return 2;
+    }
+
+    virtual bool match(const TurnPoint &tp) const {
+        return index.contains(tp.getPosition()) == inside;
+    }
+};
+
+/** the OpenAir airspace classes, see AC in the OpenAir reader */
+static const struct {
+    const char *name;
+    Airspace::type_t type;
+} airspace_types[] = {
+    { "A", Airspace::TYPE_ALPHA },
+    { "B", Airspace::TYPE_BRAVO },
+    { "C", Airspace::TYPE_CHARLY },
+    { "D", Airspace::TYPE_DELTA },
+    { "E", Airspace::TYPE_ECHO_LOW },
+    { "W", Airspace::TYPE_ECHO_HIGH },
+    { "F", Airspace::TYPE_FOX },
+    { "CTR", Airspace::TYPE_CTR },
+    { "TMZ", Airspace::TYPE_TMZ },
+    { "R", Airspace::TYPE_RESTRICTED },
+    { "Q", Airspace::TYPE_DANGER },
+    { "GSEC", Airspace::TYPE_GLIDER },
+};
+
+/**
+ * Parse a comma separated list of airspace classes into a bit mask.
+ */
+static unsigned long
+parse_types(const std::string &list)
+{
+    unsigned long mask = 0;
+    std::string::size_type start = 0;
+
+    while (start <= list.length()) {
+        std::string::size_type comma = list.find(',', start);
+        if (comma == std::string::npos)
+            comma = list.length();
+
+        const std::string name = list.substr(start, comma - start);
+        unsigned i;
+        for (i = 0; i < sizeof(airspace_types) / sizeof(airspace_types[0]);
+             ++i)
+            if (strcasecmp(name.c_str(), airspace_types[i].name) == 0)
+                break;
+
+        if (i == sizeof(airspace_types) / sizeof(airspace_types[0]))
+            throw malformed_input("Unknown airspace class: " + name);
+
+        mask |= 1ul << airspace_types[i].type;
+        start = comma + 1;
+    }
+
+    return mask;
+}
+
+TurnPointPredicate *
+AirspaceTurnPointFilter::createPredicate(const char *args) const
+{
+    if (args == NULL || *args == 0)
+        throw malformed_input("No airspace file provided");
+
+    /* FILE[:CLASS,...][:inside|:outside] */
+
+    const char *colon = strchr(args, ':');
+    const std::string path = colon == NULL
+        ? std::string(args) : std::string(args, colon - args);
+    unsigned long types = ~0ul;
+    bool inside = false;
+
+    while (colon != NULL) {
+        const char *option = colon + 1;
+        colon = strchr(option, ':');
+        const std::string value = colon == NULL
+            ? std::string(option) : std::string(option, colon - option);
+
+        if (value == "inside")
+            inside = true;
+        else if (value == "outside")
+            inside = false;
+        else
+            types = parse_types(value);
+    }
+
+    std::ifstream stream(path.c_str());
+    if (stream.fail())
+        throw std::runtime_error("Failed to open " + path);
+
+    static const OpenAirAirspaceFormat format;
+    AirspaceReader *reader = format.createReader(&stream);
+    AirspaceTurnPointPredicate *predicate =
+        new AirspaceTurnPointPredicate(inside);
+
+    try {
+        const Airspace *as;
+
+        while ((as = reader->read()) != NULL) {
+            if ((types & (1ul << as->getType())) != 0)
+                predicate->getIndex().add(*as);
+            delete as;
+        }
+    } catch (...) {
+        delete reader;
+        delete predicate;
+        throw;
+    }
+
+    delete reader;
+
+    predicate->getIndex().build();
+    return predicate;
+}
+
+unsigned
+AirspaceTurnPointFilter::getFields() const
+{
+    return TurnPoint::FIELD_POSITION;
+}
+
+TurnPointReader *
+AirspaceTurnPointFilter::createFilter(TurnPointReader *reader,
+                                      const char *args) const
+{
+    return new PredicateReader<TurnPoint>(reader, createPredicate(args));
+}
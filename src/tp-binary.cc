@@ -0,0 +1,564 @@
+/*
+ * loggertools
+ * Copyright (C) 2004-2008 Max Kellermann <max@duempel.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; version 2 of the License
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include "tp-binary.hh"
+#include "tp-io.hh"
+#include "tp-constraint.hh"
+#include "mapped-file.hh"
+#include "exception.hh"
+#include "varint.hh"
+
+#include <istream>
+#include <ostream>
+#include <streambuf>
+
+#include <string.h>
+
+/**
+ * The file header: the magic, the version, flags and one reserved
+ * byte.  Files with a newer version are rejected; attributes may be
+ * added without changing it.
+ */
+static const char BINARY_MAGIC[5] = { 'L', 'T', 'T', 'P', 'B' };
+static const unsigned char BINARY_VERSION = 1;
+static const size_t BINARY_HEADER_SIZE = 8;
+
+/** the header flag for files with a string dictionary */
+static const unsigned char BINARY_FLAG_DICTIONARY = 0x1;
+
+/** the maximum number of strings in the dictionary; later strings
+    are always stored as they are */
+static const size_t DICTIONARY_MAX = 65536;
+
+/** the number of slots in the hash table of the encoder */
+static const size_t HASH_TABLE_SIZE = 65536;
+
+/** sanity limit for the length of a record in a stream */
+static const uint64_t RECORD_MAX = 1 << 24;
+
+/** the writer passes its buffer to the stream when it is this big */
+static const size_t WRITE_BUFFER = 65536;
+
+static bool
+parse_header(const char *data, size_t length)
+{
+    if (length < BINARY_HEADER_SIZE ||
+        memcmp(data, BINARY_MAGIC, sizeof(BINARY_MAGIC)) != 0)
+        throw malformed_input("Not a binary turn point file");
+
+    if ((unsigned char)data[5] > BINARY_VERSION)
+        throw malformed_input("Unsupported version of the binary turn point file");
+
+    return (data[6] & BINARY_FLAG_DICTIONARY) != 0;
+}
+
+TurnPointEncoder::TurnPointEncoder(bool _use_dictionary)
+    :use_dictionary(_use_dictionary), latitude(0), longitude(0)
+{
+    if (use_dictionary)
+        table.resize(HASH_TABLE_SIZE);
+}
+
+/** FNV-1a */
+static uint32_t
+hash_string(const std::string &value)
+{
+    uint32_t hash = 2166136261u;
+
+    for (std::string::const_iterator it = value.begin();
+         it != value.end(); ++it)
+        hash = (hash ^ (unsigned char)*it) * 16777619u;
+
+    return hash;
+}
+
+void
+TurnPointEncoder::putString(const std::string &value, bool shared)
+{
+    char buffer[VARINT_MAX];
+
+    if (use_dictionary && shared) {
+        uint32_t &slot = table[hash_string(value) % HASH_TABLE_SIZE];
+        if (slot > 0 && strings[slot - 1] == value) {
+            record.append(buffer,
+                          put_varint(buffer, ((uint64_t)(slot - 1) << 1) | 1));
+            return;
+        }
+
+        if (strings.size() < DICTIONARY_MAX) {
+            strings.push_back(value);
+            slot = strings.size();
+        }
+
+        record.append(buffer, put_varint(buffer, (uint64_t)value.length() << 1));
+    } else
+        record.append(buffer, put_varint(buffer, value.length()));
+
+    record.append(value);
+}
+
+void
+TurnPointEncoder::encode(std::string &dest, const TurnPoint &tp)
+{
+    const Position &position = tp.getPosition();
+    const Altitude &altitude = position.getAltitude();
+    const Runway &runway = tp.getRunway();
+    char numbers[VARINT_MAX * 10], *p = numbers;
+    unsigned mask = 0;
+
+    if (position.getLatitude().defined() ||
+        position.getLongitude().defined())
+        mask |= BINARY_POSITION;
+    if (altitude.getValue() != 0 || altitude.getUnit() != Altitude::UNIT_UNKNOWN ||
+        altitude.getRef() != Altitude::REF_UNKNOWN)
+        mask |= BINARY_ALTITUDE;
+    if (tp.getType() != TurnPoint::TYPE_UNKNOWN)
+        mask |= BINARY_TYPE;
+    if (runway.getType() != Runway::TYPE_UNKNOWN ||
+        runway.getDirection() != Runway::DIRECTION_UNDEFINED ||
+        runway.getLength() != Runway::LENGTH_UNDEFINED)
+        mask |= BINARY_RUNWAY;
+    if (tp.getFrequency().getHertz() != 0)
+        mask |= BINARY_FREQUENCY;
+    if (!tp.getFullName().empty())
+        mask |= BINARY_FULL_NAME;
+    if (!tp.getShortName().empty())
+        mask |= BINARY_SHORT_NAME;
+    if (!tp.getCode().empty())
+        mask |= BINARY_CODE;
+    if (!tp.getCountry().empty())
+        mask |= BINARY_COUNTRY;
+    if (!tp.getDescription().empty())
+        mask |= BINARY_DESCRIPTION;
+
+    p = put_varint(p, mask);
+
+    if (mask & BINARY_POSITION) {
+        /* the difference wraps around, so even undefined angles
+           survive */
+        const Angle::value_t new_latitude = position.getLatitude().getValue();
+        const Angle::value_t new_longitude = position.getLongitude().getValue();
+        p = put_varint(p, zigzag((int32_t)((uint32_t)new_latitude -
+                                           (uint32_t)latitude)));
+        p = put_varint(p, zigzag((int32_t)((uint32_t)new_longitude -
+                                           (uint32_t)longitude)));
+        latitude = new_latitude;
+        longitude = new_longitude;
+    }
+
+    if (mask & BINARY_ALTITUDE) {
+        p = put_varint(p, zigzag(altitude.getValue()));
+        p = put_varint(p, altitude.getUnit() | (altitude.getRef() << 2));
+    }
+
+    if (mask & BINARY_TYPE)
+        p = put_varint(p, tp.getType());
+
+    if (mask & BINARY_RUNWAY) {
+        p = put_varint(p, runway.getType());
+        p = put_varint(p, runway.getDirection());
+        p = put_varint(p, runway.getLength());
+    }
+
+    if (mask & BINARY_FREQUENCY)
+        p = put_varint(p, tp.getFrequency().getHertz());
+
+    record.assign(numbers, p);
+
+    if (mask & BINARY_FULL_NAME)
+        putString(tp.getFullName(), false);
+    if (mask & BINARY_SHORT_NAME)
+        putString(tp.getShortName(), false);
+    if (mask & BINARY_CODE)
+        putString(tp.getCode(), false);
+    if (mask & BINARY_COUNTRY)
+        putString(tp.getCountry(), true);
+    if (mask & BINARY_DESCRIPTION)
+        putString(tp.getDescription(), true);
+
+    dest.append(numbers, put_varint(numbers, record.length()));
+    dest.append(record);
+}
+
+TurnPointDecoder::TurnPointDecoder(bool _use_dictionary)
+    :use_dictionary(_use_dictionary), latitude(0), longitude(0)
+{
+}
+
+static const char *
+get_number(const char *p, const char *end, uint64_t &value,
+           uint64_t max_value = 0xffffffff)
+{
+    p = get_varint(p, end, value);
+    if (p == NULL || value > max_value)
+        throw malformed_input("Corrupt record in binary turn point file");
+    return p;
+}
+
+const char *
+TurnPointDecoder::getString(const char *p, const char *end,
+                            std::string *dest, bool shared)
+{
+    uint64_t value;
+    p = get_number(p, end, value, ~(uint64_t)0);
+
+    shared = shared && use_dictionary;
+    if (shared) {
+        if (value & 1) {
+            if ((value >> 1) >= dictionary.size())
+                throw malformed_input("Corrupt string reference in binary turn point file");
+
+            if (dest != NULL)
+                *dest = dictionary[value >> 1];
+            return p;
+        }
+
+        value >>= 1;
+    }
+
+    if (value > (uint64_t)(end - p))
+        throw malformed_input("Corrupt record in binary turn point file");
+
+    if (dest != NULL)
+        dest->assign(p, value);
+
+    if (shared && dictionary.size() < DICTIONARY_MAX)
+        dictionary.push_back(std::string(p, value));
+
+    return p + value;
+}
+
+bool
+TurnPointDecoder::decode(const char *p, const char *end, TurnPoint &tp,
+                         unsigned fields,
+                         const TurnPointConstraint &constraint)
+{
+    uint64_t mask, value;
+    Altitude altitude;
+    TurnPoint::type_t type = TurnPoint::TYPE_UNKNOWN;
+    Runway runway;
+    unsigned frequency = 0;
+
+    p = get_number(p, end, mask, ~(uint64_t)0);
+
+    if (mask & BINARY_POSITION) {
+        p = get_number(p, end, value);
+        latitude = (Angle::value_t)((uint32_t)latitude +
+                                    (uint32_t)unzigzag(value));
+        p = get_number(p, end, value);
+        longitude = (Angle::value_t)((uint32_t)longitude +
+                                     (uint32_t)unzigzag(value));
+    }
+
+    const Latitude new_latitude = mask & BINARY_POSITION
+        ? Latitude(latitude) : Latitude();
+    const Longitude new_longitude = mask & BINARY_POSITION
+        ? Longitude(longitude) : Longitude();
+
+    if (mask & BINARY_ALTITUDE) {
+        uint64_t unit_ref;
+        p = get_number(p, end, value, ~(uint64_t)0);
+        p = get_number(p, end, unit_ref, Altitude::UNIT_FEET |
+                       (Altitude::REF_AIRFIELD << 2));
+        if ((unit_ref & 0x3) > Altitude::UNIT_FEET)
+            throw malformed_input("Corrupt altitude in binary turn point file");
+
+        altitude = Altitude((Altitude::value_t)unzigzag(value),
+                            (Altitude::unit_t)(unit_ref & 0x3),
+                            (Altitude::ref_t)(unit_ref >> 2));
+    }
+
+    if (mask & BINARY_TYPE) {
+        p = get_number(p, end, value, TurnPoint::TYPE_THERMALS);
+        type = (TurnPoint::type_t)value;
+    }
+
+    if (mask & BINARY_RUNWAY) {
+        uint64_t direction, length;
+        p = get_number(p, end, value, Runway::TYPE_ASPHALT);
+        p = get_number(p, end, direction, 36);
+        p = get_number(p, end, length);
+        runway = Runway((Runway::type_t)value, direction, length);
+    }
+
+    if (mask & BINARY_FREQUENCY) {
+        p = get_number(p, end, value);
+        frequency = value;
+    }
+
+    if (!constraint.matchType(type) ||
+        (constraint.hasPositions() &&
+         !constraint.matchPosition(SurfacePosition(new_latitude,
+                                                   new_longitude)))) {
+        /* the new strings must still go into the dictionary */
+        if (use_dictionary)
+            for (unsigned bit = BINARY_FULL_NAME;
+                 bit <= BINARY_DESCRIPTION; bit <<= 1)
+                if (mask & bit)
+                    p = getString(p, end, NULL,
+                                  (bit & BINARY_SHARED) != 0);
+
+        return false;
+    }
+
+    tp.clear();
+    tp.setPosition(Position(new_latitude, new_longitude, altitude));
+    tp.setType(type);
+    tp.setRunway(runway);
+    tp.setFrequency(Frequency(frequency));
+
+    static const struct {
+        unsigned bit, field;
+        void (TurnPoint::*set)(const std::string &);
+    } strings[] = {
+        { BINARY_FULL_NAME, TurnPoint::FIELD_FULL_NAME, &TurnPoint::setFullName },
+        { BINARY_SHORT_NAME, TurnPoint::FIELD_SHORT_NAME, &TurnPoint::setShortName },
+        { BINARY_CODE, TurnPoint::FIELD_CODE, &TurnPoint::setCode },
+        { BINARY_COUNTRY, TurnPoint::FIELD_COUNTRY, &TurnPoint::setCountry },
+        { BINARY_DESCRIPTION, TurnPoint::FIELD_DESCRIPTION, &TurnPoint::setDescription },
+    };
+
+    for (unsigned i = 0; i < sizeof(strings) / sizeof(strings[0]); ++i) {
+        const unsigned bit = strings[i].bit;
+        if ((mask & bit) == 0)
+            continue;
+
+        const bool shared = (bit & BINARY_SHARED) != 0;
+        if ((fields & strings[i].field) == 0) {
+            p = getString(p, end, NULL, shared);
+            continue;
+        }
+
+        p = getString(p, end, &buffer, shared);
+        (tp.*strings[i].set)(buffer);
+    }
+
+    return true;
+}
+
+class BinaryTurnPointReader : public TurnPointRecordReader {
+private:
+    std::istream *stream;
+    MappedFile *file;
+    const char *position;
+    std::string record;
+    TurnPointDecoder decoder;
+    unsigned count, fields;
+    ReaderPredicate predicate;
+
+public:
+    BinaryTurnPointReader(std::istream *_stream);
+
+    /**
+     * @param file the reader takes ownership
+     */
+    BinaryTurnPointReader(MappedFile *_file);
+
+    virtual ~BinaryTurnPointReader() {
+        delete file;
+    }
+
+private:
+    static bool readHeader(std::istream *stream);
+    bool readRecord(const char *&begin, const char *&end);
+
+public:
+    virtual bool setPredicate(Predicate<TurnPoint> *_predicate);
+    virtual void setFields(unsigned _fields);
+    virtual bool read_into(TurnPoint &tp);
+};
+
+bool
+BinaryTurnPointReader::readHeader(std::istream *stream)
+{
+    char header[BINARY_HEADER_SIZE];
+    size_t length = stream->rdbuf()->sgetn(header, sizeof(header));
+    return parse_header(header, length);
+}
+
+BinaryTurnPointReader::BinaryTurnPointReader(std::istream *_stream)
+    :stream(_stream), file(NULL), position(NULL),
+     decoder(readHeader(_stream)),
+     count(0), fields(TurnPoint::FIELD_ALL)
+{
+}
+
+BinaryTurnPointReader::BinaryTurnPointReader(MappedFile *_file)
+    :stream(NULL), file(_file), position(NULL),
+     decoder(parse_header(_file->begin(), _file->getSize())),
+     count(0), fields(TurnPoint::FIELD_ALL)
+{
+    position = file->begin() + BINARY_HEADER_SIZE;
+}
+
+bool
+BinaryTurnPointReader::setPredicate(Predicate<TurnPoint> *_predicate)
+{
+    if (count > 0)
+        return false;
+
+    return predicate.set(_predicate);
+}
+
+void
+BinaryTurnPointReader::setFields(unsigned _fields)
+{
+    fields = _fields;
+}
+
+/**
+ * Find the next record, either in the mapped file, or in the stream
+ * (copied to the "record" buffer).
+ */
+bool
+BinaryTurnPointReader::readRecord(const char *&begin, const char *&end)
+{
+    uint64_t length;
+
+    if (file != NULL) {
+        if (position == file->end())
+            return false;
+
+        begin = get_varint(position, file->end(), length);
+        if (begin == NULL || length > (uint64_t)(file->end() - begin))
+            throw malformed_input("Truncated binary turn point file");
+
+        end = position = begin + length;
+        return true;
+    }
+
+    std::streambuf *buffer = stream->rdbuf();
+    if (buffer->sgetc() == EOF)
+        return false;
+
+    length = 0;
+    for (unsigned shift = 0;; shift += 7) {
+        const int ch = buffer->sbumpc();
+        if (ch == EOF || shift >= 64)
+            throw malformed_input("Truncated binary turn point file");
+
+        length |= (uint64_t)(ch & 0x7f) << shift;
+        if ((ch & 0x80) == 0)
+            break;
+    }
+
+    if (length > RECORD_MAX)
+        throw malformed_input("Corrupt record in binary turn point file");
+
+    record.resize(length);
+    if (buffer->sgetn(&record[0], length) != (std::streamsize)length)
+        throw malformed_input("Truncated binary turn point file");
+
+    begin = record.data();
+    end = begin + length;
+    return true;
+}
+
+bool
+BinaryTurnPointReader::read_into(TurnPoint &tp)
+{
+    const char *begin, *end;
+
+    while (readRecord(begin, end)) {
+        ++count;
+
+        if (decoder.decode(begin, end, tp, fields,
+                           predicate.getConstraint()) &&
+            predicate.match(tp))
+            return true;
+    }
+
+    return false;
+}
+
+class BinaryTurnPointWriter : public TurnPointWriter {
+private:
+    std::ostream *stream;
+    TurnPointEncoder encoder;
+    std::string buffer;
+
+public:
+    BinaryTurnPointWriter(std::ostream *_stream, bool use_dictionary);
+
+public:
+    virtual void write(const TurnPoint &tp);
+    virtual void flush();
+};
+
+BinaryTurnPointWriter::BinaryTurnPointWriter(std::ostream *_stream,
+                                             bool use_dictionary)
+    :stream(_stream), encoder(use_dictionary)
+{
+    buffer.append(BINARY_MAGIC, sizeof(BINARY_MAGIC));
+    buffer.push_back((char)BINARY_VERSION);
+    buffer.push_back(use_dictionary ? (char)BINARY_FLAG_DICTIONARY : 0);
+    buffer.push_back(0);
+}
+
+void
+BinaryTurnPointWriter::write(const TurnPoint &tp)
+{
+    if (stream == NULL)
+        throw already_flushed();
+
+    encoder.encode(buffer, tp);
+
+    if (buffer.length() >= WRITE_BUFFER) {
+        stream->write(buffer.data(), buffer.length());
+        buffer.clear();
+    }
+}
+
+void
+BinaryTurnPointWriter::flush()
+{
+    if (stream == NULL)
+        throw already_flushed();
+
+    stream->write(buffer.data(), buffer.length());
+    buffer.clear();
+    stream = NULL;
+}
+
+TurnPointReader *
+BinaryTurnPointFormat::createReader(std::istream *stream) const
+{
+    return new BinaryTurnPointReader(stream);
+}
+
+TurnPointWriter *
+BinaryTurnPointFormat::createWriter(std::ostream *stream) const
+{
+    return new BinaryTurnPointWriter(stream, true);
+}
+
+TurnPointReader *
+BinaryTurnPointFormat::createFileReader(const char *path) const
+{
+    if (!MappedFile::isMappable(path))
+        return NULL;
+
+    MappedFile *file = new MappedFile(path);
+    try {
+        return new BinaryTurnPointReader(file);
+    } catch (...) {
+        delete file;
+        throw;
+    }
+}
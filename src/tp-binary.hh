@@ -0,0 +1,120 @@
+/*
+ * loggertools
+ * Copyright (C) 2004-2008 Max Kellermann <max@duempel.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; version 2 of the License
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef __LOGGERTOOLS_TP_BINARY_HH
+#define __LOGGERTOOLS_TP_BINARY_HH
+
+#include "tp.hh"
+
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+class TurnPointConstraint;
+
+/**
+ * The records of the binary turn point format ("tpb").  Unlike the
+ * device formats, it stores all attributes without loss.
+ *
+ * Each record starts with its length (a variable length integer,
+ * see varint.hh), followed by a bit mask of the attributes which are
+ * present (BINARY_*).  The numbers come first, so a reader can check
+ * them before it looks at the strings; the coordinates are stored as
+ * the difference to the previous record.  Readers skip attributes
+ * they don't know at the end of a record.
+ *
+ * With a dictionary, the country and the description (which often
+ * repeat, unlike names) are replaced with their number when they
+ * have been seen before.
+ */
+enum {
+    BINARY_POSITION = 0x1,
+    BINARY_ALTITUDE = 0x2,
+    BINARY_TYPE = 0x4,
+    BINARY_RUNWAY = 0x8,
+    BINARY_FREQUENCY = 0x10,
+    BINARY_FULL_NAME = 0x20,
+    BINARY_SHORT_NAME = 0x40,
+    BINARY_CODE = 0x80,
+    BINARY_COUNTRY = 0x100,
+    BINARY_DESCRIPTION = 0x200,
+
+    /** the strings which go into the dictionary */
+    BINARY_SHARED = BINARY_COUNTRY | BINARY_DESCRIPTION
+};
+
+class TurnPointEncoder {
+private:
+    bool use_dictionary;
+
+    /** the coordinates of the previous record */
+    Angle::value_t latitude, longitude;
+
+    /** the strings in the dictionary, and a hash table which maps
+        a string hash to an index in "strings" plus one; collisions
+        just overwrite older entries */
+    std::vector<std::string> strings;
+    std::vector<uint32_t> table;
+
+    std::string record;
+
+public:
+    explicit TurnPointEncoder(bool _use_dictionary);
+
+private:
+    void putString(const std::string &value, bool shared);
+
+public:
+    /**
+     * Append the record of a turn point to the buffer.
+     */
+    void encode(std::string &dest, const TurnPoint &tp);
+};
+
+class TurnPointDecoder {
+private:
+    bool use_dictionary;
+    Angle::value_t latitude, longitude;
+    std::vector<std::string> dictionary;
+
+    std::string buffer;
+
+public:
+    explicit TurnPointDecoder(bool _use_dictionary);
+
+private:
+    const char *getString(const char *p, const char *end,
+                          std::string *dest, bool shared);
+
+public:
+    /**
+     * Decode a record (without its length), and check it against the
+     * constraint before the strings are copied.  Only the specified
+     * fields are filled (see TurnPoint::FIELD_*).  Throws
+     * malformed_input on errors.
+     *
+     * @return false if the constraint rejects the turn point; tp is
+     * undefined then
+     */
+    bool decode(const char *p, const char *end, TurnPoint &tp,
+                unsigned fields, const TurnPointConstraint &constraint);
+};
+
+#endif
@@ -0,0 +1,545 @@
+/*
+ * loggertools
+ * Copyright (C) 2004-2008 Max Kellermann <max@duempel.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; version 2 of the License
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include "tp-cache.hh"
+#include "tp-constraint.hh"
+#include "mapped-file.hh"
+#include "exception.hh"
+
+#include <map>
+#include <vector>
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+static const char CACHE_MAGIC[8] = { 'T', 'P', 'C', 'A', 'C', 'H', 'E', 0 };
+
+/** the file is written in host byte order; on a machine with another
+    byte order, the version does not match, and the file is written
+    again */
+static const uint32_t CACHE_VERSION = 1;
+
+/** the number of turn points loaded with one read_batch() call */
+static const size_t LOAD_BATCH = 1024;
+
+struct CacheHeader {
+    char magic[8];
+    uint32_t version;
+
+    /** the number of turn points */
+    uint32_t count;
+
+    /** the input file this was compiled from */
+    uint64_t input_size;
+    int64_t input_mtime, input_mtime_nsec;
+    uint64_t input_hash;
+
+    /** the size of the string table, which follows the columns */
+    uint32_t strings_size;
+    uint32_t padding;
+};
+
+/**
+ * The columns which follow the header, each with one 32 bit value
+ * per turn point.  The string columns contain offsets in the string
+ * table; 0 is the empty string.
+ */
+enum column_t {
+    COLUMN_LATITUDE,
+    COLUMN_LONGITUDE,
+    COLUMN_ALTITUDE,
+    COLUMN_ALTITUDE_UNIT,
+    COLUMN_ALTITUDE_REF,
+    COLUMN_TYPE,
+    COLUMN_RUNWAY_TYPE,
+    COLUMN_RUNWAY_DIRECTION,
+    COLUMN_RUNWAY_LENGTH,
+    COLUMN_FREQUENCY,
+    COLUMN_FULL_NAME,
+    COLUMN_SHORT_NAME,
+    COLUMN_CODE,
+    COLUMN_COUNTRY,
+    COLUMN_DESCRIPTION,
+    NUM_COLUMNS
+};
+
+/**
+ * Calculate the FNV-1a hash of a file.
+ */
+static uint64_t
+hash_file(const char *path)
+{
+    const MappedFile file(path);
+    uint64_t hash = 14695981039346656037ull;
+
+    for (const char *p = file.begin(); p != file.end(); ++p)
+        hash = (hash ^ (unsigned char)*p) * 1099511628211ull;
+
+    return hash;
+}
+
+static std::string
+hex(uint64_t value)
+{
+    char buffer[17];
+    snprintf(buffer, sizeof(buffer), "%016llx", (unsigned long long)value);
+    return buffer;
+}
+
+TurnPointCache::TurnPointCache(const char *_input, const char *directory)
+    :input(_input), valid(false), size(0), mtime(0), mtime_nsec(0)
+{
+    struct stat st;
+
+    if (stat(input, &st) == 0 && S_ISREG(st.st_mode)) {
+        valid = true;
+        size = (uint64_t)st.st_size;
+        mtime = (int64_t)st.st_mtim.tv_sec;
+        mtime_nsec = (int64_t)st.st_mtim.tv_nsec;
+    }
+
+    if (directory == NULL) {
+        path = std::string(input) + ".tpc";
+        return;
+    }
+
+    /* several input files may have the same name; the hash of the
+       absolute path tells them apart */
+    char buffer[PATH_MAX];
+    const char *absolute = realpath(input, buffer);
+    if (absolute == NULL)
+        absolute = input;
+
+    uint64_t path_hash = 14695981039346656037ull;
+    for (const char *p = absolute; *p != 0; ++p)
+        path_hash = (path_hash ^ (unsigned char)*p) * 1099511628211ull;
+
+    const char *slash = strrchr(input, '/');
+    path = std::string(directory) + "/" +
+        (slash != NULL ? slash + 1 : input) + "-" + hex(path_hash) + ".tpc";
+}
+
+/**
+ * Reads the turn points from a mapped cache file.
+ */
+class CachedTurnPointReader : public TurnPointRecordReader {
+private:
+    MappedFile *file;
+    uint32_t count, position;
+    const uint32_t *columns[NUM_COLUMNS];
+    const char *strings;
+    uint32_t strings_size;
+    unsigned fields;
+    ReaderPredicate predicate;
+
+public:
+    /**
+     * @param file a file which has been checked with check_file();
+     * the reader takes ownership
+     */
+    CachedTurnPointReader(MappedFile *_file);
+
+    virtual ~CachedTurnPointReader() {
+        delete file;
+    }
+
+private:
+    const char *getString(column_t column, uint32_t i) const {
+        const uint32_t offset = columns[column][i];
+        if (offset >= strings_size)
+            throw malformed_input("Corrupt cache file");
+        return strings + offset;
+    }
+
+public:
+    virtual bool setPredicate(Predicate<TurnPoint> *_predicate);
+    virtual void setFields(unsigned _fields);
+    virtual bool read_into(TurnPoint &tp);
+};
+
+CachedTurnPointReader::CachedTurnPointReader(MappedFile *_file)
+    :file(_file), position(0), fields(TurnPoint::FIELD_ALL)
+{
+    const CacheHeader *header = (const CacheHeader*)file->begin();
+    const uint32_t *column = (const uint32_t*)(header + 1);
+
+    count = header->count;
+    for (unsigned i = 0; i < NUM_COLUMNS; ++i, column += count)
+        columns[i] = column;
+
+    strings = (const char*)column;
+    strings_size = header->strings_size;
+}
+
+bool
+CachedTurnPointReader::setPredicate(Predicate<TurnPoint> *_predicate)
+{
+    if (position > 0)
+        return false;
+
+    return predicate.set(_predicate);
+}
+
+void
+CachedTurnPointReader::setFields(unsigned _fields)
+{
+    fields = _fields;
+}
+
+bool
+CachedTurnPointReader::read_into(TurnPoint &tp)
+{
+    const TurnPointConstraint &constraint = predicate.getConstraint();
+
+    while (position < count) {
+        const uint32_t i = position++;
+
+        /* the columns of the constraint are checked before the
+           strings are copied */
+        const TurnPoint::type_t type =
+            (TurnPoint::type_t)columns[COLUMN_TYPE][i];
+        if (!constraint.matchType(type))
+            continue;
+
+        const Latitude latitude((int)columns[COLUMN_LATITUDE][i]);
+        const Longitude longitude((int)columns[COLUMN_LONGITUDE][i]);
+        if (constraint.hasPositions() &&
+            !constraint.matchPosition(SurfacePosition(latitude, longitude)))
+            continue;
+
+        tp.clear();
+
+        if ((fields & TurnPoint::FIELD_FULL_NAME) != 0)
+            tp.setFullName(getString(COLUMN_FULL_NAME, i));
+        if ((fields & TurnPoint::FIELD_SHORT_NAME) != 0)
+            tp.setShortName(getString(COLUMN_SHORT_NAME, i));
+        if ((fields & TurnPoint::FIELD_CODE) != 0)
+            tp.setCode(getString(COLUMN_CODE, i));
+        if ((fields & TurnPoint::FIELD_COUNTRY) != 0)
+            tp.setCountry(getString(COLUMN_COUNTRY, i));
+        if ((fields & TurnPoint::FIELD_DESCRIPTION) != 0)
+            tp.setDescription(getString(COLUMN_DESCRIPTION, i));
+
+        tp.setPosition(Position(latitude, longitude,
+                                Altitude((int32_t)columns[COLUMN_ALTITUDE][i],
+                                         (Altitude::unit_t)columns[COLUMN_ALTITUDE_UNIT][i],
+                                         (Altitude::ref_t)columns[COLUMN_ALTITUDE_REF][i])));
+        tp.setType(type);
+        tp.setRunway(Runway((Runway::type_t)columns[COLUMN_RUNWAY_TYPE][i],
+                            columns[COLUMN_RUNWAY_DIRECTION][i],
+                            columns[COLUMN_RUNWAY_LENGTH][i]));
+        tp.setFrequency(Frequency(columns[COLUMN_FREQUENCY][i]));
+
+        if (predicate.match(tp))
+            return true;
+    }
+
+    return false;
+}
+
+/**
+ * Check whether all values of a column are at most "max_value".
+ */
+static bool
+check_column(const uint32_t *column, uint32_t count, uint32_t max_value)
+{
+    for (uint32_t i = 0; i < count; ++i)
+        if (column[i] > max_value)
+            return false;
+
+    return true;
+}
+
+/**
+ * Check the values of a complete cache file which are passed to
+ * constructors (enums, the runway direction) or used as offsets, so
+ * a corrupt file cannot crash the reader.
+ */
+static bool
+check_columns(const CacheHeader *header)
+{
+    const uint32_t count = header->count;
+    const uint32_t *columns[NUM_COLUMNS];
+    const uint32_t *column = (const uint32_t*)(header + 1);
+
+    for (unsigned i = 0; i < NUM_COLUMNS; ++i, column += count)
+        columns[i] = column;
+
+    if (!check_column(columns[COLUMN_ALTITUDE_UNIT], count,
+                      Altitude::UNIT_FEET) ||
+        !check_column(columns[COLUMN_ALTITUDE_REF], count,
+                      Altitude::REF_AIRFIELD) ||
+        !check_column(columns[COLUMN_TYPE], count,
+                      TurnPoint::TYPE_THERMALS) ||
+        !check_column(columns[COLUMN_RUNWAY_TYPE], count,
+                      Runway::TYPE_ASPHALT) ||
+        !check_column(columns[COLUMN_RUNWAY_DIRECTION], count, 36))
+        return false;
+
+    for (unsigned i = COLUMN_FULL_NAME; i <= COLUMN_DESCRIPTION; ++i)
+        if (!check_column(columns[i], count, header->strings_size - 1))
+            return false;
+
+    return true;
+}
+
+/**
+ * Check whether the mapped file is a complete and valid cache file.
+ */
+static bool
+check_file(const MappedFile &file)
+{
+    if (file.getSize() < sizeof(CacheHeader))
+        return false;
+
+    const CacheHeader *header = (const CacheHeader*)file.begin();
+    if (memcmp(header->magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 ||
+        header->version != CACHE_VERSION)
+        return false;
+
+    const uint64_t expected = sizeof(*header) +
+        (uint64_t)header->count * NUM_COLUMNS * sizeof(uint32_t) +
+        header->strings_size;
+
+    /* the string table must end with a null byte, so no string can
+       run past the end of the file */
+    return file.getSize() == expected && header->strings_size > 0 &&
+        file.end()[-1] == 0 && check_columns(header);
+}
+
+TurnPointReader *
+TurnPointCache::open() const
+{
+    if (!valid)
+        return NULL;
+
+    MappedFile *file;
+    try {
+        file = new MappedFile(path.c_str());
+    } catch (const std::runtime_error &e) {
+        return NULL;
+    }
+
+    if (!check_file(*file)) {
+        delete file;
+        return NULL;
+    }
+
+    const CacheHeader *header = (const CacheHeader*)file->begin();
+    if (header->input_size != size) {
+        delete file;
+        return NULL;
+    }
+
+    if (header->input_mtime != mtime ||
+        header->input_mtime_nsec != mtime_nsec) {
+        /* the input file has been touched; compare its contents, and
+           remember the new modification time if they are the same */
+        uint64_t hash;
+        try {
+            hash = hash_file(input);
+        } catch (const std::runtime_error &e) {
+            delete file;
+            return NULL;
+        }
+
+        if (hash != header->input_hash) {
+            delete file;
+            return NULL;
+        }
+
+        const int64_t times[2] = { mtime, mtime_nsec };
+        int fd = ::open(path.c_str(), O_WRONLY);
+        if (fd >= 0) {
+            if (pwrite(fd, times, sizeof(times),
+                       offsetof(CacheHeader, input_mtime)) < 0) {
+                /* ignore; the hash is compared again next time */
+            }
+            close(fd);
+        }
+    }
+
+    return new CachedTurnPointReader(file);
+}
+
+/**
+ * Collects the columns and the string table of a cache file.
+ */
+class CacheBuilder {
+private:
+    std::vector<uint32_t> columns[NUM_COLUMNS];
+    std::string strings;
+    std::map<std::string, uint32_t> offsets;
+
+public:
+    CacheBuilder():strings(1, '\0') {}
+
+private:
+    uint32_t addString(const std::string &value) {
+        if (value.empty())
+            return 0;
+
+        std::map<std::string, uint32_t>::iterator it = offsets.find(value);
+        if (it != offsets.end())
+            return it->second;
+
+        const uint32_t offset = strings.length();
+        strings.append(value.c_str(), value.length() + 1);
+        offsets.insert(std::make_pair(value, offset));
+        return offset;
+    }
+
+public:
+    size_t size() const {
+        return columns[0].size();
+    }
+
+    size_t getStringsSize() const {
+        return strings.length();
+    }
+
+    void add(const TurnPoint &tp) {
+        const Position &position = tp.getPosition();
+        const Altitude &altitude = position.getAltitude();
+        const Runway &runway = tp.getRunway();
+
+        columns[COLUMN_LATITUDE].push_back(position.getLatitude().getValue());
+        columns[COLUMN_LONGITUDE].push_back(position.getLongitude().getValue());
+        columns[COLUMN_ALTITUDE].push_back(altitude.getValue());
+        columns[COLUMN_ALTITUDE_UNIT].push_back(altitude.getUnit());
+        columns[COLUMN_ALTITUDE_REF].push_back(altitude.getRef());
+        columns[COLUMN_TYPE].push_back(tp.getType());
+        columns[COLUMN_RUNWAY_TYPE].push_back(runway.getType());
+        columns[COLUMN_RUNWAY_DIRECTION].push_back(runway.getDirection());
+        columns[COLUMN_RUNWAY_LENGTH].push_back(runway.getLength());
+        columns[COLUMN_FREQUENCY].push_back(tp.getFrequency().getHertz());
+        columns[COLUMN_FULL_NAME].push_back(addString(tp.getFullName()));
+        columns[COLUMN_SHORT_NAME].push_back(addString(tp.getShortName()));
+        columns[COLUMN_CODE].push_back(addString(tp.getCode()));
+        columns[COLUMN_COUNTRY].push_back(addString(tp.getCountry()));
+        columns[COLUMN_DESCRIPTION].push_back(addString(tp.getDescription()));
+    }
+
+    bool write(int fd) const;
+};
+
+static bool
+write_full(int fd, const void *data, size_t length)
+{
+    const char *p = (const char*)data;
+
+    while (length > 0) {
+        ssize_t nbytes = ::write(fd, p, length);
+        if (nbytes < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+
+        p += nbytes;
+        length -= (size_t)nbytes;
+    }
+
+    return true;
+}
+
+bool
+CacheBuilder::write(int fd) const
+{
+    for (unsigned i = 0; i < NUM_COLUMNS; ++i)
+        if (!columns[i].empty() &&
+            !write_full(fd, &columns[i][0],
+                        columns[i].size() * sizeof(columns[i][0])))
+            return false;
+
+    return write_full(fd, strings.data(), strings.length());
+}
+
+bool
+TurnPointCache::write(TurnPointReader &reader) const
+{
+    CacheBuilder builder;
+    std::vector<TurnPoint> buffer(LOAD_BATCH);
+    size_t n;
+
+    while ((n = reader.read_batch(&buffer[0], buffer.size())) > 0)
+        for (size_t i = 0; i < n; ++i)
+            builder.add(buffer[i]);
+
+    if (!valid || builder.size() > 0xffffffffu ||
+        builder.getStringsSize() > 0xffffffffu) {
+        errno = EFBIG;
+        return false;
+    }
+
+    CacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.version = CACHE_VERSION;
+    header.count = builder.size();
+    header.input_size = size;
+    header.input_mtime = mtime;
+    header.input_mtime_nsec = mtime_nsec;
+    header.strings_size = builder.getStringsSize();
+
+    try {
+        header.input_hash = hash_file(input);
+    } catch (const std::runtime_error &e) {
+        return false;
+    }
+
+    /* write a temporary file, and rename it when it is complete, so
+       other processes never see a partial cache file */
+
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), ".tmp%ld", (long)getpid());
+    const std::string tmp = path + suffix;
+
+    int fd = ::open(tmp.c_str(), O_WRONLY|O_CREAT|O_TRUNC, 0666);
+    if (fd < 0)
+        return false;
+
+    bool success = write_full(fd, &header, sizeof(header)) &&
+        builder.write(fd);
+    int e = errno;
+
+    if (close(fd) < 0 && success) {
+        success = false;
+        e = errno;
+    }
+
+    if (success && rename(tmp.c_str(), path.c_str()) < 0) {
+        success = false;
+        e = errno;
+    }
+
+    if (!success) {
+        unlink(tmp.c_str());
+        errno = e;
+    }
+
+    return success;
+}
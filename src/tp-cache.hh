@@ -0,0 +1,87 @@
+/*
+ * loggertools
+ * Copyright (C) 2004-2008 Max Kellermann <max@duempel.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; version 2 of the License
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef __LOGGERTOOLS_TP_CACHE_HH
+#define __LOGGERTOOLS_TP_CACHE_HH
+
+#include "tp.hh"
+#include "tp-io.hh"
+
+#include <string>
+
+#include <stdint.h>
+
+/**
+ * A compiled copy of a turn point file, which can be mapped into
+ * memory and read much faster than parsing the original.  It stores
+ * each attribute in a column of 32 bit integers, and the strings in a
+ * table which contains each one only once.
+ *
+ * The cache file remembers the size, the modification time and a
+ * hash of the input file.  It is used as long as the size and the
+ * modification time are unchanged, or if only the modification time
+ * has changed, but the contents are the same.
+ */
+class TurnPointCache {
+private:
+    const char *input;
+    std::string path;
+
+    /** the state of the input file when this object was created */
+    bool valid;
+    uint64_t size;
+    int64_t mtime, mtime_nsec;
+
+public:
+    /**
+     * @param directory the directory where cache files are stored;
+     * if NULL, the cache file is stored next to the input file
+     */
+    TurnPointCache(const char *input, const char *directory);
+
+public:
+    const std::string &getPath() const {
+        return path;
+    }
+
+    /**
+     * Can the input be cached at all?  Only regular files can.
+     */
+    bool isCacheable() const {
+        return valid;
+    }
+
+    /**
+     * Open the cache file.  Returns NULL if it does not exist, or if
+     * it is out of date.
+     */
+    TurnPointReader *open() const;
+
+    /**
+     * Load all turn points from the reader (without deleting it), and
+     * write them to a new cache file.  Errors of the reader are
+     * passed on.
+     *
+     * @return false if the cache file could not be written; errno
+     * is set then
+     */
+    bool write(TurnPointReader &reader) const;
+};
+
+#endif
@@ -20,6 +20,7 @@
 #include "exception.hh"
 #include "tp.hh"
 #include "tp-io.hh"
+#include "tp-constraint.hh"
 #include "cenfis-db.h"
 
 #include <vector>
@@ -28,16 +29,21 @@
 #include <netinet/in.h>
 #include <string.h>
 
-class CenfisDatabaseReader : public TurnPointReader {
+class CenfisDatabaseReader : public TurnPointRecordReader {
 private:
     std::istream *stream;
     struct header header;
     unsigned current, overall_count;
+    ReaderPredicate predicate;
 public:
     CenfisDatabaseReader(std::istream *stream);
     virtual ~CenfisDatabaseReader();
+private:
+    void parse(const struct turn_point &data, const Position &position,
+               TurnPoint::type_t type, TurnPoint &tp);
 public:
-    virtual const TurnPoint *read();
+    virtual bool setPredicate(Predicate<TurnPoint> *_predicate);
+    virtual bool read_into(TurnPoint &tp);
 };
 
 CenfisDatabaseReader::CenfisDatabaseReader(std::istream *_stream)
@@ -65,54 +71,41 @@ const T cenfisToAngle(int value) {
     return T(value, 600);
 }
 
-const TurnPoint *CenfisDatabaseReader::read() {
-    struct turn_point data;
-    TurnPoint *tp;
-    char title[sizeof(data.title) + 1];
-    char description[sizeof(data.description) + 1];
-    size_t length;
-
-    if (current >= overall_count)
-        return NULL;
-
-    /* read this record */
-    stream->read((char*)&data, sizeof(data));
-
-    ++current;
-
-    /* create object */
-    tp = new TurnPoint();
-
-    /* position */
-    tp->setPosition(Position(cenfisToAngle<Latitude>(ntohl(data.latitude)),
-                             cenfisToAngle<Longitude>(-ntohl(data.longitude)),
-                             Altitude(ntohs(data.altitude),
-                                      Altitude::UNIT_METERS,
-                                      Altitude::REF_MSL)));
-
-    /* type */
-    switch (data.type) {
+static TurnPoint::type_t
+cenfisToType(char type)
+{
+    switch (type) {
     case 1:
-        tp->setType(TurnPoint::TYPE_AIRFIELD);
-        break;
+        return TurnPoint::TYPE_AIRFIELD;
     case 2:
-        tp->setType(TurnPoint::TYPE_GLIDER_SITE);
-        break;
+        return TurnPoint::TYPE_GLIDER_SITE;
     case 3:
-        tp->setType(TurnPoint::TYPE_MILITARY_AIRFIELD);
-        break;
+        return TurnPoint::TYPE_MILITARY_AIRFIELD;
     case 4:
-        tp->setType(TurnPoint::TYPE_OUTLANDING);
-        break;
+        return TurnPoint::TYPE_OUTLANDING;
     case 5:
-        tp->setType(TurnPoint::TYPE_THERMALS);
-        break;
+        return TurnPoint::TYPE_THERMALS;
     default:
-        tp->setType(TurnPoint::TYPE_UNKNOWN);
+        return TurnPoint::TYPE_UNKNOWN;
     }
+}
+
+void
+CenfisDatabaseReader::parse(const struct turn_point &data,
+                            const Position &position,
+                            TurnPoint::type_t type, TurnPoint &tp)
+{
+    char title[sizeof(data.title) + 1];
+    char description[sizeof(data.description) + 1];
+    size_t length;
+
+    tp.clear();
+
+    tp.setPosition(position);
+    tp.setType(type);
 
     /* frequency */
-    tp->setFrequency(Frequency(((data.freq[0] << 16) +
+    tp.setFrequency(Frequency(((data.freq[0] << 16) +
                                 (data.freq[1] << 8) +
                                 data.freq[2]) * 1000));
 
@@ -125,7 +118,7 @@ const TurnPoint *CenfisDatabaseReader::read() {
     title[length] = 0;
 
     if (title[0] != 0)
-        tp->setFullName(title);
+        tp.setFullName(title);
 
     /* extract description */
     length = sizeof(data.description);
@@ -136,7 +129,7 @@ const TurnPoint *CenfisDatabaseReader::read() {
     description[length] = 0;
 
     if (description[0] != 0)
-        tp->setDescription(description);
+        tp.setDescription(description);
 
     /* runway */
 
@@ -145,11 +138,51 @@ const TurnPoint *CenfisDatabaseReader::read() {
         if (direction < 1 || direction > 36)
             direction = Runway::DIRECTION_UNDEFINED;
 
-        tp->setRunway(Runway(Runway::TYPE_UNKNOWN, direction,
+        tp.setRunway(Runway(Runway::TYPE_UNKNOWN, direction,
                              Runway::LENGTH_UNDEFINED));
     }
+}
+
+bool
+CenfisDatabaseReader::setPredicate(Predicate<TurnPoint> *_predicate)
+{
+    if (current > 0)
+        return false;
+
+    return predicate.set(_predicate);
+}
+
+bool CenfisDatabaseReader::read_into(TurnPoint &tp) {
+    const TurnPointConstraint &constraint = predicate.getConstraint();
+    struct turn_point data;
+
+    while (current < overall_count) {
+        /* read this record */
+        stream->read((char*)&data, sizeof(data));
+
+        ++current;
+
+        /* check type and position on the raw record; the strings
+           are only copied if it matches */
+        const TurnPoint::type_t type = cenfisToType(data.type);
+        if (!constraint.matchType(type))
+            continue;
+
+        const Position position(cenfisToAngle<Latitude>(ntohl(data.latitude)),
+                                cenfisToAngle<Longitude>(-ntohl(data.longitude)),
+                                Altitude(ntohs(data.altitude),
+                                         Altitude::UNIT_METERS,
+                                         Altitude::REF_MSL));
+        if (!constraint.matchPosition(position))
+            continue;
+
+        parse(data, position, type, tp);
+
+        if (predicate.match(tp))
+            return true;
+    }
 
-    return tp;
+    return false;
 }
 
 TurnPointReader *
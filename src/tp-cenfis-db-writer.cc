@@ -45,6 +45,7 @@ public:
 public:
     virtual void write(const TurnPoint &tp);
     virtual void flush();
+    virtual unsigned getFields() const;
 };
 
 CenfisDatabaseWriter::CenfisDatabaseWriter(std::ostream *_stream)
@@ -184,9 +185,10 @@ void CenfisDatabaseWriter::flush() {
     foo_offset = sizeof(header) + sizeof(struct turn_point) * tps.size();
     table_offset = foo_offset + sizeof(struct foo);
 
-    /* sort TPs alphabetically */
+    /* sort TPs alphabetically; TPs with the same title keep the
+       order in which they were written, e.g. by an "order" filter */
 
-    sort(tps.begin(), tps.end());
+    stable_sort(tps.begin(), tps.end());
 
     /* build tables */
 
@@ -254,6 +256,12 @@ void CenfisDatabaseWriter::flush() {
     stream = NULL;
 }
 
+unsigned CenfisDatabaseWriter::getFields() const {
+    return TurnPoint::FIELD_NAMES | TurnPoint::FIELD_POSITION |
+        TurnPoint::FIELD_TYPE | TurnPoint::FIELD_RUNWAY |
+        TurnPoint::FIELD_FREQUENCY | TurnPoint::FIELD_DESCRIPTION;
+}
+
 TurnPointWriter *
 CenfisDatabaseFormat::createWriter(std::ostream *stream) const {
     return new CenfisDatabaseWriter(stream);
@@ -193,6 +193,7 @@ public:
     virtual ~CenfisHexReader();
 public:
     virtual const TurnPoint *read();
+    virtual size_t read_batch(TurnPoint *buffer, size_t max_count);
 };
 
 CenfisHexReader::CenfisHexReader(std::istream *_stream)
@@ -230,6 +231,13 @@ const TurnPoint *CenfisHexReader::read() {
     return NULL;
 }
 
+size_t CenfisHexReader::read_batch(TurnPoint *buffer, size_t max_count) {
+    if (tpr != NULL)
+        return tpr->read_batch(buffer, max_count);
+
+    return 0;
+}
+
 TurnPointReader *
 CenfisHexTurnPointFormat::createReader(std::istream *stream) const {
     return new CenfisHexReader(stream);
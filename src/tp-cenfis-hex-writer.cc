@@ -31,7 +31,9 @@ public:
     CenfisHexWriter(std::ostream *stream);
 public:
     virtual void write(const TurnPoint &tp);
+    virtual void write_batch(const TurnPoint *buffer, size_t count);
     virtual void flush();
+    virtual unsigned getFields() const;
 };
 
 CenfisHexWriter::CenfisHexWriter(std::ostream *stream)
@@ -49,11 +51,19 @@ void CenfisHexWriter::write(const TurnPoint &tp) {
     tpw->write(tp);
 }
 
+void CenfisHexWriter::write_batch(const TurnPoint *buffer, size_t count) {
+    tpw->write_batch(buffer, count);
+}
+
 void CenfisHexWriter::flush() {
     tpw->flush();
     out.flush();
 }
 
+unsigned CenfisHexWriter::getFields() const {
+    return tpw->getFields();
+}
+
 TurnPointWriter *
 CenfisHexTurnPointFormat::createWriter(std::ostream *stream) const {
     return new CenfisHexWriter(stream);
@@ -21,30 +21,28 @@
 #include "tp-io.hh"
 
 #include <istream>
+#include <algorithm>
 
 #include <stdlib.h>
 #include <string.h>
 
-class CenfisTurnPointReader : public TurnPointReader {
+class CenfisTurnPointReader : public TurnPointRecordReader {
 private:
     std::istream *stream;
-    TurnPoint *tp;
+
+    /** the turn point which is currently being parsed */
+    TurnPoint current;
+    bool have_current;
 public:
     CenfisTurnPointReader(std::istream *stream);
-    virtual ~CenfisTurnPointReader();
 protected:
-    TurnPoint *handleLine(char *line);
+    bool handleLine(char *line, TurnPoint &dest);
 public:
-    virtual const TurnPoint *read();
+    virtual bool read_into(TurnPoint &tp);
 };
 
 CenfisTurnPointReader::CenfisTurnPointReader(std::istream *_stream)
-    :stream(_stream), tp(NULL) {
-}
-
-CenfisTurnPointReader::~CenfisTurnPointReader() {
-    if (tp != NULL)
-        delete tp;
+    :stream(_stream), have_current(false) {
 }
 
 template<class T, char minusLetter, char plusLetter>
@@ -220,8 +218,12 @@ static Runway *parseRunway(char *p) {
     return new Runway(type, direction, length);
 }
 
-TurnPoint *CenfisTurnPointReader::handleLine(char *line) {
-    TurnPoint *ret;
+/**
+ * Parses one line.  When a turn point is complete, it is moved to
+ * dest, and true is returned.
+ */
+bool CenfisTurnPointReader::handleLine(char *line, TurnPoint &dest) {
+    bool ret;
     char *p;
     size_t length;
 
@@ -242,15 +244,22 @@ TurnPoint *CenfisTurnPointReader::handleLine(char *line) {
 
     /* check code */
     if (strncmp(line, "11 ", 3) == 0) {
-        ret = tp;
-        tp = new TurnPoint();
+        ret = have_current;
+        if (ret)
+            std::swap(dest, current);
+        current.clear();
+        have_current = true;
     } else if (strncmp(line, "   ", 3) == 0) {
-        ret = NULL;
+        if (!have_current)
+            return false;
+        ret = false;
     } else if (*line == 0 || *line == ' ') {
-        return NULL;
+        return false;
     } else {
-        ret = tp;
-        tp = NULL;
+        ret = have_current;
+        if (ret)
+            std::swap(dest, current);
+        have_current = false;
         return ret;
     }
 
@@ -265,29 +274,30 @@ TurnPoint *CenfisTurnPointReader::handleLine(char *line) {
         line += 2;
 
         if (*line != 0)
-            tp->setFullName(line);
+            current.setFullName(line);
         break;
 
     case 'T': /* type and description */
         line += 2;
 
         if (strncmp(line, " # ", 3) == 0)
-            tp->setType(TurnPoint::TYPE_AIRFIELD);
+            current.setType(TurnPoint::TYPE_AIRFIELD);
         else if (strncmp(line, " #M", 3) == 0)
-            tp->setType(TurnPoint::TYPE_MILITARY_AIRFIELD);
+            current.setType(TurnPoint::TYPE_MILITARY_AIRFIELD);
         else if (strncmp(line, " #S", 3) == 0)
-            tp->setType(TurnPoint::TYPE_GLIDER_SITE);
+            current.setType(TurnPoint::TYPE_GLIDER_SITE);
         else if (strncmp(line, "LW ", 3) == 0)
-            tp->setType(TurnPoint::TYPE_OUTLANDING);
+            current.setType(TurnPoint::TYPE_OUTLANDING);
         else if (strncmp(line, "TQ ", 3) == 0)
-            tp->setType(TurnPoint::TYPE_THERMALS);
+            current.setType(TurnPoint::TYPE_THERMALS);
         else
-            tp->setType(TurnPoint::TYPE_UNKNOWN);
+            current.setType(TurnPoint::TYPE_UNKNOWN);
 
-        line += 4;
+        /* don't skip past the end of short lines like " #S" */
+        line += strnlen(line, 4);
 
         if (*line != 0 && strcmp(line, "Waypoint") != 0)
-            tp->setDescription(line);
+            current.setDescription(line);
 
         break;
 
@@ -309,7 +319,7 @@ TurnPoint *CenfisTurnPointReader::handleLine(char *line) {
 
             altitude = parseAltitude(line);
 
-            tp->setPosition(Position(latitude, longitude, altitude));
+            current.setPosition(Position(latitude, longitude, altitude));
         }
         break;
 
@@ -331,12 +341,12 @@ TurnPoint *CenfisTurnPointReader::handleLine(char *line) {
 
             altitude = parseAltitude(line);
 
-            tp->setPosition(Position(latitude, longitude, altitude));
+            current.setPosition(Position(latitude, longitude, altitude));
         }
         break;
 
     case 'F': /* frequency */
-        tp->setFrequency(parseFrequency(line + 2));
+        current.setFrequency(parseFrequency(line + 2));
         break;
 
     case 'R': /* runway */
@@ -345,7 +355,7 @@ TurnPoint *CenfisTurnPointReader::handleLine(char *line) {
 
             rwy = parseRunway(line + 2);
             if (rwy != NULL) {
-                tp->setRunway(*rwy);
+                current.setRunway(*rwy);
                 delete rwy;
             }
         }
@@ -355,9 +365,8 @@ TurnPoint *CenfisTurnPointReader::handleLine(char *line) {
     return ret;
 }
 
-const TurnPoint *CenfisTurnPointReader::read() {
+bool CenfisTurnPointReader::read_into(TurnPoint &tp) {
     char line[1024];
-    TurnPoint *ret = NULL;
 
     while (!stream->eof()) {
         try {
@@ -369,12 +378,11 @@ const TurnPoint *CenfisTurnPointReader::read() {
                 throw;
         }
 
-        ret = handleLine(line);
-        if (ret != NULL)
-            return ret;
+        if (handleLine(line, tp))
+            return true;
     }
 
-    return NULL;
+    return false;
 }
 
 TurnPointReader *
@@ -35,6 +35,7 @@ public:
 public:
     virtual void write(const TurnPoint &tp);
     virtual void flush();
+    virtual unsigned getFields() const;
 };
 
 CenfisTurnPointWriter::CenfisTurnPointWriter(std::ostream *_stream)
@@ -176,6 +177,12 @@ void CenfisTurnPointWriter::flush() {
     stream = NULL;
 }
 
+unsigned CenfisTurnPointWriter::getFields() const {
+    return TurnPoint::FIELD_NAMES | TurnPoint::FIELD_POSITION |
+        TurnPoint::FIELD_TYPE | TurnPoint::FIELD_RUNWAY |
+        TurnPoint::FIELD_FREQUENCY | TurnPoint::FIELD_DESCRIPTION;
+}
+
 TurnPointWriter *CenfisTurnPointFormat::createWriter(std::ostream *stream) const {
     return new CenfisTurnPointWriter(stream);
 }
@@ -17,40 +17,28 @@
  * 02111-1307, USA.
  */
 
-#ifndef __LOGGERTOOLS_IO_MATCH_HH
-#define __LOGGERTOOLS_IO_MATCH_HH
-
-#include "io.hh"
-
-/**
- * A Reader class which returns all objects matching the Match
- * operation.
- */
-template<class T, class Match>
-class MatchReader : public Reader<T> {
-private:
-    Reader<T> *reader;
-    Match match;
-
-public:
-    MatchReader(Reader<T> *_reader, Match _match)
-        :reader(_reader), match(_match) {}
-
-    virtual ~MatchReader() {
-        delete reader;
-    }
-
-public:
-    virtual const T *read() {
-        while (true) {
-            const T *t = reader->read();
-            if (t == NULL || match(*t))
-                return t;
-
-            /* this object didn't pass the filter: delete it */
-            delete t;
-        }
+#include "tp-constraint.hh"
+#include "io-predicate.hh"
+
+TurnPointConstraint::TurnPointConstraint(const Predicate<TurnPoint> &predicate)
+    :types(~0ul), complete(true)
+{
+    add(predicate);
+}
+
+void
+TurnPointConstraint::add(const Predicate<TurnPoint> &predicate)
+{
+    const PredicateList<TurnPoint> *list =
+        dynamic_cast<const PredicateList<TurnPoint>*>(&predicate);
+    if (list != NULL) {
+        for (size_t i = 0; i < list->size(); ++i)
+            add((*list)[i]);
+        return;
     }
-};
 
-#endif
+    const TurnPointPredicate *tpp =
+        dynamic_cast<const TurnPointPredicate*>(&predicate);
+    if (tpp == NULL || !tpp->constrain(*this))
+        complete = false;
+}
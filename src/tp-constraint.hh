@@ -0,0 +1,147 @@
+/*
+ * loggertools
+ * Copyright (C) 2004-2008 Max Kellermann <max@duempel.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; version 2 of the License
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef __LOGGERTOOLS_TP_CONSTRAINT_HH
+#define __LOGGERTOOLS_TP_CONSTRAINT_HH
+
+#include "tp.hh"
+#include "tp-io.hh"
+
+#include <vector>
+
+/**
+ * Conditions on the fields of a turn point which a reader knows
+ * before it builds the TurnPoint object: the type and the position.
+ * Records which are rejected here can be skipped without copying
+ * their strings.
+ */
+class TurnPointConstraint {
+private:
+    /** one bit for each accepted TurnPoint::type_t */
+    unsigned long types;
+
+    /** the position must be inside all of these */
+    std::vector<SurfaceCircle> circles;
+
+    /** is this equivalent to the predicate it was created from? */
+    bool complete;
+
+public:
+    TurnPointConstraint()
+        :types(~0ul), complete(true) {}
+
+    /**
+     * Create the constraint of a predicate, which may be a
+     * PredicateList.
+     */
+    explicit TurnPointConstraint(const Predicate<TurnPoint> &predicate);
+
+private:
+    void add(const Predicate<TurnPoint> &predicate);
+
+public:
+    void restrictTypes(unsigned long mask) {
+        types &= mask;
+    }
+
+    void addCircle(const SurfaceCircle &circle) {
+        circles.push_back(circle);
+    }
+
+    bool isComplete() const {
+        return complete;
+    }
+
+    bool hasTypes() const {
+        return types != ~0ul;
+    }
+
+    bool hasPositions() const {
+        return !circles.empty();
+    }
+
+    bool matchType(TurnPoint::type_t type) const {
+        return (types & (1ul << type)) != 0;
+    }
+
+    bool matchPosition(const SurfacePosition &position) const {
+        for (std::vector<SurfaceCircle>::const_iterator it = circles.begin();
+             it != circles.end(); ++it)
+            if (!it->contains(position))
+                return false;
+
+        return true;
+    }
+};
+
+/**
+ * The predicate of a reader which implements setPredicate().  The
+ * reader checks the constraint on each raw record, and calls match()
+ * after it has built the TurnPoint.
+ */
+class ReaderPredicate {
+private:
+    Predicate<TurnPoint> *predicate;
+    TurnPointConstraint constraint;
+
+public:
+    ReaderPredicate():predicate(NULL) {}
+
+    ~ReaderPredicate() {
+        if (predicate != NULL)
+            delete predicate;
+    }
+
+private:
+    /* no copying */
+    ReaderPredicate(const ReaderPredicate &);
+    void operator =(const ReaderPredicate &);
+
+public:
+    bool defined() const {
+        return predicate != NULL;
+    }
+
+    /**
+     * Take ownership of the predicate.  Returns false if there is
+     * already one.
+     */
+    bool set(Predicate<TurnPoint> *_predicate) {
+        if (predicate != NULL)
+            return false;
+
+        predicate = _predicate;
+        constraint = TurnPointConstraint(*predicate);
+        return true;
+    }
+
+    const TurnPointConstraint &getConstraint() const {
+        return constraint;
+    }
+
+    /**
+     * Check a turn point which has passed the constraint.
+     */
+    bool match(const TurnPoint &tp) const {
+        return predicate == NULL || constraint.isComplete() ||
+            predicate->match(tp);
+    }
+};
+
+#endif
@@ -19,29 +19,141 @@
 
 #include "tp.hh"
 #include "tp-io.hh"
+#include "tp-index.hh"
+#include "tp-dedupe.hh"
+#include "tp-cache.hh"
+#include "tp-order.hh"
+#include "io-predicate.hh"
+#include "io-fanout.hh"
+#include "io-pipeline.hh"
+#include "io-parallel.hh"
 
 #include <fstream>
 #include <iostream>
 #include <list>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
 
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
 #include <getopt.h>
+#include <unistd.h>
 
 using std::cout;
 using std::cerr;
 using std::endl;
 
+/** the number of turn points transferred with one read_batch() call */
+static const size_t BATCH_SIZE = 256;
+
+/** the number of batches which may be queued for each output, when
+    there are several */
+static const size_t QUEUE_SIZE = 16;
+
+/** the number of batches in the ring between the reader and the
+    writer thread, see option -p */
+static const size_t RING_SIZE = 8;
+
+/** the number of batches each input may be ahead when several of
+    them are read in parallel */
+static const size_t INPUT_QUEUE_SIZE = 4;
+
+typedef std::list<const char*> FilterList;
+
+/**
+ * An output file, or stdout.
+ */
+struct Output {
+    /** NULL for stdout */
+    const char *filename;
+    const TurnPointFormat *format;
+    /** NULL if the file has not been created yet */
+    std::ostream *stream;
+    /** the filters which select the turn points of this output
+        (option -s) */
+    FilterList selections;
+    /** the writer of this output, if it is written on its own (see
+        option -s); otherwise, it is owned by the main writer */
+    TurnPointWriter *writer;
+
+    Output(const char *_filename, const TurnPointFormat *_format)
+        :filename(_filename), format(_format), stream(NULL),
+         writer(NULL) {}
+};
+
+typedef std::vector<Output> OutputList;
+
 static void usage(const char *argv0) {
     cout << "usage: " << argv0 << " [options] FILE1 ...\n"
         "options:\n"
-        " -o outfile   write output to this file\n"
+        " -o outfile   write output to this file (may be repeated)\n"
+        " -s filter    write only the turn points selected by this filter\n"
+        "              to the last -o file (may be repeated)\n"
         " -f outformat write output to stdout with this format\n"
         " -F filter    use a filter\n"
+        " -p           read and write in separate threads\n"
+        " -j jobs      read input files in parallel (0 = one per CPU)\n"
+        " -u           with -j, don't keep the order of the input files\n"
+        " -C           cache the parsed input files next to them\n"
+        " -c dir       cache the parsed input files in this directory\n"
+        " -m, --memory size\n"
+        "              memory for sorting (\"order\" filter), with an\n"
+        "              optional suffix k, M or G; more is sorted on disk\n"
         " -h           help (this text)\n";
 }
 
+static const struct option long_options[] = {
+    { "help", no_argument, NULL, 'h' },
+    { "memory", required_argument, NULL, 'm' },
+    { NULL, 0, NULL, 0 }
+};
+
+/**
+ * Parse a size in bytes, with an optional suffix "k", "M" or "G".
+ * Returns 0 on error, e.g. if the size does not fit into size_t.
+ */
+static size_t
+parse_size(const char *p)
+{
+    /* strtoul() would accept a negative number */
+    if (*p < '0' || *p > '9')
+        return 0;
+
+    char *endptr;
+    errno = 0;
+    unsigned long value = strtoul(p, &endptr, 10);
+    if (errno != 0 || value > (size_t)-1)
+        return 0;
+
+    unsigned shift = 0;
+    switch (*endptr) {
+    case 'k':
+    case 'K':
+        shift = 10;
+        ++endptr;
+        break;
+
+    case 'm':
+    case 'M':
+        shift = 20;
+        ++endptr;
+        break;
+
+    case 'g':
+    case 'G':
+        shift = 30;
+        ++endptr;
+        break;
+    }
+
+    if (*endptr != 0 || value > ((size_t)-1 >> shift))
+        return 0;
+
+    return (size_t)value << shift;
+}
+
 static void arg_error(const char *argv0, const char *msg)
     __attribute__((noreturn));
 static void
@@ -53,6 +165,98 @@ arg_error(const char *argv0, const char *msg)
     exit(1);
 }
 
+/**
+ * Split a filter specification ("NAME" or "NAME:ARGS"), and look up
+ * the filter.
+ */
+static const TurnPointFilter *
+parse_filter_spec(const char *spec, std::string &name, const char *&args)
+{
+    const char *colon = strchr(spec, ':');
+
+    if (colon != NULL) {
+        name.assign(spec, colon - spec);
+        args = colon + 1;
+    } else {
+        name.assign(spec);
+        args = NULL;
+    }
+
+    return getTurnPointFilter(name.c_str());
+}
+
+/**
+ * Is this filter specification ("NAME" or "NAME:ARGS") for the
+ * specified filter?
+ */
+static bool
+is_filter(const char *spec, const char *name)
+{
+    const size_t length = strlen(name);
+
+    return strncmp(spec, name, length) == 0 &&
+        (spec[length] == 0 || spec[length] == ':');
+}
+
+/**
+ * The fields used by the filters in the list.
+ */
+static unsigned
+get_filter_fields(const FilterList &filters)
+{
+    unsigned fields = 0;
+
+    for (FilterList::const_iterator it = filters.begin();
+         it != filters.end(); ++it) {
+        std::string filter_name;
+        const char *args;
+        const TurnPointFilter *filter
+            = parse_filter_spec(*it, filter_name, args);
+        if (filter != NULL)
+            fields |= filter->getFields();
+    }
+
+    return fields;
+}
+
+/**
+ * Let the reader check the predicates, or wrap it in a
+ * PredicateReader if it cannot do that.  The reader owns the
+ * predicates afterwards, and a new empty list is returned in
+ * "predicates".
+ */
+static TurnPointReader *
+apply_predicates(TurnPointReader *reader,
+                 PredicateList<TurnPoint> *&predicates)
+{
+    if (predicates->empty())
+        return reader;
+
+    if (!reader->setPredicate(predicates))
+        reader = new PredicateReader<TurnPoint>(reader, predicates);
+
+    predicates = new PredicateList<TurnPoint>();
+    return reader;
+}
+
+/**
+ * Delete the writers, and the output files which have been created.
+ * This is called after an error.
+ */
+static void
+abort_outputs(TurnPointWriter *writer, const OutputList &outputs)
+{
+    delete writer;
+
+    for (OutputList::const_iterator it = outputs.begin();
+         it != outputs.end(); ++it) {
+        delete it->writer;
+
+        if (it->stream != NULL && it->filename != NULL)
+            unlink(it->filename);
+    }
+}
+
 const TurnPointFormat *getFormatFromFilename(const char *filename) {
     const char *dot;
     const TurnPointFormat *format;
@@ -72,18 +276,372 @@ const TurnPointFormat *getFormatFromFilename(const char *filename) {
     return format;
 }
 
+/**
+ * Apply a range of filters to the reader.  Filters which can be
+ * expressed as a predicate are combined, until a filter comes which
+ * depends on the stream; with an index, each filter queries it
+ * instead.  On error, "reader" is the partially filtered reader,
+ * which must be deleted by the caller.
+ */
+static void
+apply_filters(TurnPointReader *&reader, FilterList::const_iterator begin,
+              FilterList::const_iterator end, bool indexed)
+{
+    PredicateList<TurnPoint> *predicates = new PredicateList<TurnPoint>();
+
+    for (FilterList::const_iterator it = begin; it != end; ++it) {
+        std::string filter_name;
+        const char *args;
+        const TurnPointFilter *filter
+            = parse_filter_spec(*it, filter_name, args);
+        if (filter == NULL) {
+            delete predicates;
+            throw std::runtime_error("Unknown filter '" + filter_name + "'");
+        }
+
+        try {
+            Predicate<TurnPoint> *predicate = indexed
+                ? NULL
+                : filter->createPredicate(args);
+            if (predicate != NULL) {
+                predicates->add(predicate);
+                continue;
+            }
+
+            reader = apply_predicates(reader, predicates);
+            reader = filter->createFilter(reader, args);
+        } catch (const std::exception &e) {
+            delete predicates;
+            throw std::runtime_error("Failed to initialize filter '" +
+                                     filter_name + "': " + e.what());
+        }
+    }
+
+    reader = apply_predicates(reader, predicates);
+    delete predicates;
+}
+
+/**
+ * The input files, each with its own reader and filter chain.
+ */
+class InputFiles : public ReaderSource<TurnPoint> {
+private:
+    struct Input {
+        const char *filename;
+        const TurnPointFormat *format;
+        std::ifstream *stream;
+
+        Input(const char *_filename, const TurnPointFormat *_format)
+            :filename(_filename), format(_format), stream(NULL) {}
+    };
+
+    std::vector<Input> inputs;
+    const FilterList &filters;
+    /** the fields used by the writer and the filters */
+    unsigned fields;
+    /** load each input into a spatial index? */
+    bool indexed;
+    /** use a TurnPointCache for each input? */
+    bool cached;
+    /** where the cache files are stored; NULL means next to the
+        input files */
+    const char *cache_directory;
+
+public:
+    InputFiles(const FilterList &_filters, unsigned _fields,
+               bool _indexed)
+        :filters(_filters), fields(_fields), indexed(_indexed),
+         cached(false), cache_directory(NULL) {}
+
+    virtual ~InputFiles() {
+        for (std::vector<Input>::iterator it = inputs.begin();
+             it != inputs.end(); ++it)
+            delete it->stream;
+    }
+
+    void add(const char *filename) {
+        inputs.push_back(Input(filename, getFormatFromFilename(filename)));
+    }
+
+    void setCache(const char *directory) {
+        cached = true;
+        cache_directory = directory;
+    }
+
+    virtual size_t size() const {
+        return inputs.size();
+    }
+
+    const char *getFilename(size_t i) const {
+        return inputs[i].filename;
+    }
+
+    virtual TurnPointReader *open(size_t i);
+
+private:
+    TurnPointReader *openFile(Input &input);
+    TurnPointReader *openCache(Input &input);
+};
+
+/**
+ * Create a reader which parses the input file.
+ */
+TurnPointReader *
+InputFiles::openFile(Input &input)
+{
+    TurnPointReader *reader;
+
+    /* some formats can read the file directly (without the stream),
+       e.g. by mapping it into memory */
+    reader = input.format->createFileReader(input.filename);
+    if (reader != NULL)
+        return reader;
+
+    delete input.stream;
+    input.stream = new std::ifstream(input.filename);
+    if (input.stream->fail()) {
+        std::ostringstream msg;
+        msg << "Failed to open " << input.filename
+            << ": " << strerror(errno);
+        throw std::runtime_error(msg.str());
+    }
+
+    input.stream->exceptions(std::ios_base::badbit |
+                             std::ios_base::failbit);
+
+    reader = input.format->createReader(input.stream);
+    if (reader == NULL)
+        throw std::runtime_error("Reading this type is not supported");
+
+    return reader;
+}
+
+/**
+ * Create a reader for the cache file of the input.  If it is missing
+ * or out of date, the input is parsed, and a new cache file is
+ * written.  Returns NULL if that fails.
+ */
+TurnPointReader *
+InputFiles::openCache(Input &input)
+{
+    const TurnPointCache cache(input.filename, cache_directory);
+    if (!cache.isCacheable())
+        return NULL;
+
+    TurnPointReader *reader = cache.open();
+    if (reader != NULL)
+        return reader;
+
+    /* the cache must contain all turn points with all fields, so
+       the input is parsed without predicates */
+    reader = openFile(input);
+
+    bool success;
+    try {
+        success = cache.write(*reader);
+    } catch (...) {
+        delete reader;
+        throw;
+    }
+
+    delete reader;
+    delete input.stream;
+    input.stream = NULL;
+
+    if (!success) {
+        cerr << "Failed to write " << cache.getPath() << ": "
+             << strerror(errno) << endl;
+        return NULL;
+    }
+
+    return cache.open();
+}
+
+TurnPointReader *
+InputFiles::open(size_t i)
+{
+    Input &input = inputs[i];
+    TurnPointReader *reader = cached ? openCache(input) : NULL;
+
+    if (reader == NULL)
+        reader = openFile(input);
+
+    reader->setFields(fields);
+
+    if (indexed) {
+        /* several distance filters: load the input into a spatial
+           index, which they can query; on error, the input is deleted
+           by IndexedTurnPointReader */
+        reader = new IndexedTurnPointReader(reader);
+    }
+
+    try {
+        apply_filters(reader, filters.begin(), filters.end(), indexed);
+    } catch (...) {
+        delete reader;
+        throw;
+    }
+
+    return reader;
+}
+
+/**
+ * Create a reader which returns the turn points of all input files,
+ * with the filters from "merge_filter" to "end" (if any) applied to
+ * them.  "dedupe" reads the files one after another; otherwise, they
+ * are read with a ParallelReader (in parallel with -j).  "order"
+ * gets the memory limit, all other filters are created as usual.
+ */
+static TurnPointReader *
+open_merged(InputFiles &inputs, FilterList::const_iterator merge_filter,
+            FilterList::const_iterator end, unsigned jobs, bool ordered,
+            size_t memory_limit)
+{
+    TurnPointReader *reader = NULL, *input = NULL;
+    FilterList::const_iterator next = merge_filter;
+
+    try {
+        if (merge_filter != end && is_filter(*merge_filter, "dedupe")) {
+            const char *args = strchr(*merge_filter, ':');
+            DedupeTurnPointReader *dedupe;
+            try {
+                dedupe = new DedupeTurnPointReader(args != NULL
+                                                   ? args + 1 : NULL);
+            } catch (const std::exception &e) {
+                throw std::runtime_error(std::string("Failed to initialize "
+                                                     "filter 'dedupe': ") +
+                                         e.what());
+            }
+
+            reader = dedupe;
+
+            for (size_t i = 0; i < inputs.size(); ++i) {
+                input = inputs.open(i);
+                dedupe->add(*input, inputs.getFilename(i));
+                delete input;
+                input = NULL;
+            }
+
+            ++next;
+        } else {
+            reader = inputs.size() > 1
+                ? new ParallelReader<TurnPoint>(inputs, jobs, ordered,
+                                                BATCH_SIZE,
+                                                INPUT_QUEUE_SIZE)
+                : inputs.open(0);
+
+            if (merge_filter != end && is_filter(*merge_filter, "order")) {
+                const char *args = strchr(*merge_filter, ':');
+                try {
+                    reader = new OrderTurnPointReader(reader,
+                                                      args != NULL
+                                                      ? args + 1 : NULL,
+                                                      memory_limit);
+                } catch (const std::exception &e) {
+                    throw std::runtime_error(std::string("Failed to initialize "
+                                                         "filter 'order': ") +
+                                             e.what());
+                }
+
+                ++next;
+            }
+        }
+
+        apply_filters(reader, next, end, false);
+    } catch (...) {
+        delete input;
+        delete reader;
+        throw;
+    }
+
+    return reader;
+}
+
+/**
+ * Copy all objects from the reader to the writer.  With a pipeline,
+ * the reader parses directly into its ring buffer.
+ */
+static void
+transfer(TurnPointReader *reader, TurnPointWriter *writer,
+         PipelineWriter<TurnPoint> *pipeline, std::vector<TurnPoint> &buffer)
+{
+    size_t n;
+
+    if (pipeline != NULL) {
+        while ((n = reader->read_batch(pipeline->begin_batch(),
+                                       BATCH_SIZE)) > 0)
+            pipeline->commit_batch(n);
+    } else {
+        while ((n = reader->read_batch(&buffer[0], buffer.size())) > 0)
+            writer->write_batch(&buffer[0], n);
+    }
+}
+
+/**
+ * Load the turn points from the reader (and delete it) into one
+ * index, and write each output with its own selection of it (option
+ * -s).  The index is queried by the "distance", "name" and "nearest"
+ * filters of each output, instead of reading and checking all input
+ * files again.
+ */
+static void
+write_selections(TurnPointReader *input, OutputList &outputs,
+                 std::vector<TurnPoint> &buffer)
+{
+    TurnPointIndex index;
+
+    try {
+        index.load(*input);
+    } catch (...) {
+        delete input;
+        throw;
+    }
+
+    delete input;
+
+    for (OutputList::iterator it = outputs.begin();
+         it != outputs.end(); ++it) {
+        TurnPointReader *reader = new IndexedTurnPointReader(index);
+
+        try {
+            apply_filters(reader, it->selections.begin(),
+                          it->selections.end(), true);
+            transfer(reader, it->writer, NULL, buffer);
+        } catch (...) {
+            delete reader;
+            throw;
+        }
+
+        delete reader;
+
+        it->writer->flush();
+        delete it->writer;
+        it->writer = NULL;
+    }
+}
+
 int main(int argc, char **argv) {
-    const char *out_filename = NULL, *stdout_format = NULL;
-    std::list<const char*> filters;
-    const TurnPointFormat *out_format;
+    const char *stdout_format = NULL;
+    std::vector<const char*> out_filenames;
+    /** the -s options of each -o option */
+    std::vector<FilterList> out_selections;
+    bool selecting = false;
+    FilterList filters;
+    bool pipelined = false, ordered = true, cached = false;
+    size_t memory_limit = OrderTurnPointReader::DEFAULT_MEMORY;
+    const char *cache_directory = NULL;
+    unsigned jobs = 1;
+    OutputList outputs;
     TurnPointWriter *writer;
-    const TurnPoint *tp;
+    PipelineWriter<TurnPoint> *pipeline = NULL;
+    std::vector<TurnPoint> buffer(BATCH_SIZE);
 
     /* parse command line arguments */
     while (1) {
         int c;
 
-        c = getopt(argc, argv, "ho:f:F:");
+        c = getopt_long(argc, argv, "ho:s:f:F:pj:uCc:m:",
+                        long_options, NULL);
         if (c == -1)
             break;
 
@@ -93,19 +651,56 @@ int main(int argc, char **argv) {
             return 0;
 
         case 'o':
-            out_filename = optarg;
-            stdout_format = NULL;
+            out_filenames.push_back(optarg);
+            out_selections.push_back(FilterList());
+            break;
+
+        case 's':
+            if (out_selections.empty())
+                arg_error(argv[0], "-s must follow an -o option");
+
+            out_selections.back().push_back(optarg);
+            selecting = true;
             break;
 
         case 'f':
             stdout_format = optarg;
-            out_filename = NULL;
             break;
 
         case 'F':
             filters.push_back(optarg);
             break;
 
+        case 'p':
+            pipelined = true;
+            break;
+
+        case 'j':
+            jobs = (unsigned)strtoul(optarg, NULL, 10);
+            if (jobs == 0)
+                jobs = Thread::countProcessors();
+            break;
+
+        case 'u':
+            ordered = false;
+            break;
+
+        case 'C':
+            cached = true;
+            cache_directory = NULL;
+            break;
+
+        case 'c':
+            cached = true;
+            cache_directory = optarg;
+            break;
+
+        case 'm':
+            memory_limit = parse_size(optarg);
+            if (memory_limit == 0)
+                arg_error(argv[0], "Invalid memory limit");
+            break;
+
         case '?':
             arg_error(argv[0], NULL);
 
@@ -114,115 +709,226 @@ int main(int argc, char **argv) {
         }
     }
 
-    if (out_filename == NULL && stdout_format == NULL)
+    if (out_filenames.empty() && stdout_format == NULL)
         arg_error(argv[0], "No output filename specified");
 
     if (optind >= argc)
         arg_error(argv[0], "No input filename specified");
 
-    /* open output file */
+    /* determine the output formats */
 
-    std::ostream *out;
+    for (size_t i = 0; i < out_filenames.size(); ++i) {
+        outputs.push_back(Output(out_filenames[i],
+                                 getFormatFromFilename(out_filenames[i])));
+        outputs.back().selections = out_selections[i];
+    }
 
-    if (out_filename == NULL) {
-        out_format = getTurnPointFormat(stdout_format);
-        if (out_format == NULL) {
+    if (stdout_format != NULL) {
+        const TurnPointFormat *format = getTurnPointFormat(stdout_format);
+        if (format == NULL) {
             cerr << "Format '" << stdout_format << "' is not supported"
                  << endl;
             exit(1);
         }
 
-        out = &cout;
-    } else {
-        out_format = getFormatFromFilename(out_filename);
+        outputs.push_back(Output(NULL, format));
+    }
+
+    /* open the output files; with more than one, each writer gets
+       its own thread, and they are all fed from one FanOutWriter;
+       with -s, each output is written on its own */
+
+    FanOutWriter<TurnPoint> *fan_out = outputs.size() > 1 && !selecting
+        ? new FanOutWriter<TurnPoint>(QUEUE_SIZE)
+        : NULL;
+    writer = fan_out;
+
+    for (OutputList::iterator it = outputs.begin();
+         it != outputs.end(); ++it) {
+        std::ostream *out;
+
+        if (it->filename == NULL) {
+            out = &cout;
+        } else {
+            out = new std::ofstream(it->filename);
+            if (out->fail()) {
+                cerr << "Failed to create " << it->filename
+                     << ": " << strerror(errno) << endl;
+                abort_outputs(writer, outputs);
+                exit(2);
+            }
+        }
+
+        it->stream = out;
+        out->exceptions(std::ios_base::badbit | std::ios_base::failbit);
+
+        TurnPointWriter *w = it->format->createWriter(out);
+        if (w == NULL) {
+            abort_outputs(writer, outputs);
+            cerr << "Writing this type is not supported" << endl;
+            exit(1);
+        }
+
+        if (selecting) {
+            it->writer = w;
+            continue;
+        }
+
+        if (fan_out == NULL) {
+            writer = w;
+            continue;
+        }
 
-        out = new std::ofstream(out_filename);
-        if (out->fail()) {
-            cerr << "Failed to create " << out_filename
-                 << ": " << strerror(errno) << endl;
+        try {
+            fan_out->add(w);
+        } catch (const std::exception &e) {
+            delete w;
+            abort_outputs(writer, outputs);
+            cerr << e.what() << endl;
             exit(2);
         }
     }
 
-    out->exceptions(std::ios_base::badbit | std::ios_base::failbit);
+    /* with -p, the writer runs in its own thread, and the reader
+       parses directly into its ring buffer; with several outputs,
+       this is already done by the FanOutWriter */
 
-    writer = out_format->createWriter(out);
-    if (writer == NULL) {
-        unlink(out_filename);
-        cerr << "Writing this type is not supported" << endl;
-        exit(1);
-    }
+    if (pipelined && fan_out == NULL && !selecting) {
+        try {
+            pipeline = new PipelineWriter<TurnPoint>(writer, BATCH_SIZE,
+                                                     RING_SIZE);
+        } catch (const std::exception &e) {
+            /* the writer has been deleted by PipelineWriter */
+            abort_outputs(NULL, outputs);
+            cerr << e.what() << endl;
+            exit(2);
+        }
 
-    /* read all input files */
+        writer = pipeline;
+    }
 
-    while (optind < argc) {
-        const char *in_filename = argv[optind++];
+    /* the readers only need to parse the fields which are used by
+       the writer and the filters */
+
+    unsigned fields = get_filter_fields(filters);
+
+    if (selecting) {
+        for (OutputList::const_iterator it = outputs.begin();
+             it != outputs.end(); ++it)
+            fields |= it->writer->getFields() |
+                get_filter_fields(it->selections);
+    } else
+        fields |= writer->getFields();
+
+    /* the "dedupe", "order" and "nearest" filters work on the turn
+       points of all input files; the filters before the first of
+       them are applied to each file, the others to the merged turn
+       points */
+
+    FilterList::const_iterator merge_filter = filters.begin();
+    while (merge_filter != filters.end() &&
+           !is_filter(*merge_filter, "dedupe") &&
+           !is_filter(*merge_filter, "order") &&
+           !is_filter(*merge_filter, "nearest"))
+        ++merge_filter;
+
+    const FilterList file_filters(FilterList::const_iterator(filters.begin()),
+                                  merge_filter);
+
+    unsigned num_distance_filters = 0;
+    for (FilterList::const_iterator it = file_filters.begin();
+         it != file_filters.end(); ++it)
+        if (is_filter(*it, "distance"))
+            ++num_distance_filters;
+
+    /* read all input files; with -j, several of them are read in
+       parallel, and the objects are merged into the writer */
+
+    InputFiles inputs(file_filters, fields, num_distance_filters > 1);
+    if (cached)
+        inputs.setCache(cache_directory);
+    while (optind < argc)
+        inputs.add(argv[optind++]);
+
+    if (selecting) {
+        try {
+            write_selections(open_merged(inputs, merge_filter,
+                                         filters.end(), jobs, ordered,
+                                         memory_limit),
+                             outputs, buffer);
+        } catch (const std::exception &e) {
+            abort_outputs(writer, outputs);
+            cerr << e.what() << endl;
+            exit(2);
+        }
+    } else if (merge_filter != filters.end()) {
+        TurnPointReader *reader = NULL;
 
-        const TurnPointFormat *in_format = getFormatFromFilename(in_filename);
-        std::ifstream in(in_filename);
-        if (in.fail()) {
-            cerr << "Failed to open " << in_filename
-                 << ": " << strerror(errno) << endl;
+        try {
+            reader = open_merged(inputs, merge_filter, filters.end(),
+                                 jobs, ordered, memory_limit);
+            transfer(reader, writer, pipeline, buffer);
+        } catch (const std::exception &e) {
+            delete reader;
+            abort_outputs(writer, outputs);
+            cerr << e.what() << endl;
             exit(2);
         }
 
-        in.exceptions(std::ios_base::badbit | std::ios_base::failbit);
+        delete reader;
+    } else if (jobs > 1 && inputs.size() > 1) {
+        TurnPointReader *reader = NULL;
 
-        TurnPointReader *reader = in_format->createReader(&in);
-        if (reader == NULL) {
-            cerr << "Reading this type is not supported" << endl;
-            exit(1);
+        try {
+            reader = new ParallelReader<TurnPoint>(inputs, jobs, ordered,
+                                                   BATCH_SIZE,
+                                                   INPUT_QUEUE_SIZE);
+            transfer(reader, writer, pipeline, buffer);
+        } catch (const std::exception &e) {
+            delete reader;
+            abort_outputs(writer, outputs);
+            cerr << e.what() << endl;
+            exit(2);
         }
 
-        for (std::list<const char*>::const_iterator it = filters.begin();
-             it != filters.end(); ++it) {
-            std::string s = *it;
-            int colon = s.find(':');
-            std::string filter_name = colon >= 0
-                ? std::string(s, 0, colon)
-                : s;
-            const char *args = colon >= 0
-                ? std::string(s, colon + 1).c_str()
-                : NULL;
-            const TurnPointFilter *filter
-                = getTurnPointFilter(filter_name.c_str());
+        delete reader;
+    } else {
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            TurnPointReader *reader = NULL;
+
             try {
-                reader = filter->createFilter(reader, args);
+                reader = inputs.open(i);
+                transfer(reader, writer, pipeline, buffer);
             } catch (const std::exception &e) {
-                delete writer;
                 delete reader;
-                unlink(out_filename);
-                cerr << "Failed to initialize filter '" << filter_name
-                     << "': " << e.what() << endl;
+                abort_outputs(writer, outputs);
+                cerr << e.what() << endl;
                 exit(2);
             }
+
+            delete reader;
         }
+    }
 
-        /* transfer data */
+    if (writer != NULL) {
         try {
-            while ((tp = reader->read()) != NULL) {
-                writer->write(*tp);
-                delete tp;
-            }
+            writer->flush();
         } catch (const std::exception &e) {
-            delete writer;
-            delete reader;
-            unlink(out_filename);
+            abort_outputs(writer, outputs);
             cerr << e.what() << endl;
             exit(2);
         }
 
-        delete reader;
+        delete writer;
     }
 
-    writer->flush();
-
-    delete writer;
-
-    if (out == &cout)
-        out->flush();
-    else
-        delete out;
+    for (OutputList::const_iterator it = outputs.begin();
+         it != outputs.end(); ++it) {
+        if (it->stream == &cout)
+            it->stream->flush();
+        else
+            delete it->stream;
+    }
 
     return 0;
 }
@@ -0,0 +1,319 @@
+/*
+ * loggertools
+ * Copyright (C) 2004-2008 Max Kellermann <max@duempel.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; version 2 of the License
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+#include "exception.hh"
+#include "tp.hh"
+#include "tp-io.hh"
+#include "tp-dedupe.hh"
+#include "earth-parser.hh"
+
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+#include <strings.h>
+
+/**
+ * Can these two turn points be the same place?  Types which are not
+ * known don't contradict anything, and all kinds of airfields are
+ * considered equal, because the sources disagree on them.
+ */
+static bool
+compatible_types(TurnPoint::type_t a, TurnPoint::type_t b)
+{
+    return a == b || a == TurnPoint::TYPE_UNKNOWN ||
+        b == TurnPoint::TYPE_UNKNOWN ||
+        (TurnPoint::isAirfield(a) && TurnPoint::isAirfield(b));
+}
+
+/**
+ * Fill the attributes of "dest" which are not set with the ones of
+ * "src".
+ */
+static void
+merge_attributes(TurnPointTable::Record &dest,
+                 const TurnPointTable::Record &src)
+{
+    if (dest.full_name == StringPool::EMPTY)
+        dest.full_name = src.full_name;
+    if (dest.short_name == StringPool::EMPTY)
+        dest.short_name = src.short_name;
+    if (dest.code == StringPool::EMPTY)
+        dest.code = src.code;
+    if (dest.country == StringPool::EMPTY)
+        dest.country = src.country;
+    if (dest.type == TurnPoint::TYPE_UNKNOWN)
+        dest.type = src.type;
+    if (!dest.runway.defined())
+        dest.runway = src.runway;
+    if (!dest.frequency.defined())
+        dest.frequency = src.frequency;
+    if (dest.description == StringPool::EMPTY)
+        dest.description = src.description;
+}
+
+/**
+ * A hash grid over the unit vectors of the turn points which have
+ * been kept so far.  The cells are at least as large as the chord of
+ * the radius, so all neighbours are in the 27 cells around a
+ * position.
+ */
+class DedupeGrid {
+    double cell_size;
+    /** the first entry of each bucket, or -1 */
+    std::vector<int> buckets;
+    /** the next entry in the same bucket, or -1 */
+    std::vector<int> next;
+    std::vector<unsigned> numbers;
+    std::vector<PreparedPosition> positions;
+
+public:
+    DedupeGrid(double _cell_size, size_t size)
+        :cell_size(_cell_size) {
+        size_t n = 64;
+        while (n < size * 2)
+            n *= 2;
+        buckets.resize(n, -1);
+    }
+
+private:
+    long cell(double value) const {
+        return (long)floor(value / cell_size);
+    }
+
+    size_t bucket(long x, long y, long z) const {
+        return ((unsigned long)x * 73856093ul ^
+                (unsigned long)y * 19349663ul ^
+                (unsigned long)z * 83492791ul) & (buckets.size() - 1);
+    }
+
+public:
+    void add(unsigned number, const PreparedPosition &position) {
+        size_t b = bucket(cell(position.getX()), cell(position.getY()),
+                          cell(position.getZ()));
+
+        next.push_back(buckets[b]);
+        buckets[b] = (int)numbers.size();
+        numbers.push_back(number);
+        positions.push_back(position);
+    }
+
+    /**
+     * Find the nearest entry which is not farther away than the
+     * radius, and for which the function object returns true.
+     *
+     * @return the number of the entry, or -1
+     */
+    template<class F>
+    int findNearest(const PreparedPosition &position,
+                    const Distance &radius, F &f) const {
+        const long cx = cell(position.getX());
+        const long cy = cell(position.getY());
+        const long cz = cell(position.getZ());
+        int best = -1;
+        double best_distance = radius.getMeters();
+
+        for (long x = cx - 1; x <= cx + 1; ++x) {
+            for (long y = cy - 1; y <= cy + 1; ++y) {
+                for (long z = cz - 1; z <= cz + 1; ++z) {
+                    /* other cells may share this bucket; the distance
+                       check sorts them out */
+                    for (int i = buckets[bucket(x, y, z)]; i >= 0;
+                         i = next[i]) {
+                        double distance =
+                            (positions[i] - position).getMeters();
+                        if (distance <= best_distance && f(numbers[i])) {
+                            best = i;
+                            best_distance = distance;
+                        }
+                    }
+                }
+            }
+        }
+
+        return best >= 0 ? (int)numbers[best] : -1;
+    }
+};
+
+/**
+ * The condition for merging a turn point into a kept one.
+ */
+class DedupeCompatible {
+    const TurnPointTable &points;
+    const TurnPoint::type_t type;
+
+public:
+    DedupeCompatible(const TurnPointTable &_points,
+                     TurnPoint::type_t _type)
+        :points(_points), type(_type) {}
+
+    bool operator ()(unsigned i) const {
+        return compatible_types(points[i].type, type);
+    }
+};
+
+/**
+ * Sorts turn point numbers by their rank, keeping the original order
+ * of equal ranks.
+ */
+class DedupeCompareRank {
+    const std::vector<unsigned> &ranks;
+
+public:
+    DedupeCompareRank(const std::vector<unsigned> &_ranks)
+        :ranks(_ranks) {}
+
+    bool operator ()(unsigned a, unsigned b) const {
+        return ranks[a] < ranks[b];
+    }
+};
+
+DedupeTurnPointReader::DedupeTurnPointReader(const char *args)
+    :merged(false), position(0) {
+    if (args == NULL || *args == 0)
+        throw malformed_input("No radius provided");
+
+    const char *colon = strchr(args, ':');
+    const std::string radius_string = colon != NULL
+        ? std::string(args, colon - args)
+        : std::string(args);
+
+    radius = parseDistance(radius_string.c_str()).getMeters();
+    if (!(radius > 0))
+        throw malformed_input("The radius must be positive");
+
+    if (colon == NULL)
+        return;
+
+    const char *p = colon + 1;
+    while (true) {
+        const char *comma = strchr(p, ',');
+        const size_t length = comma != NULL ? (size_t)(comma - p) : strlen(p);
+
+        if (length == 0)
+            throw malformed_input("Empty source name");
+
+        priorities.push_back(std::string(p, length));
+
+        if (comma == NULL)
+            break;
+        p = comma + 1;
+    }
+}
+
+unsigned
+DedupeTurnPointReader::getRank(const std::string &source) const
+{
+    const char *dot = strrchr(source.c_str(), '.');
+
+    for (unsigned i = 0; i < priorities.size(); ++i)
+        if (strcasecmp(priorities[i].c_str(), source.c_str()) == 0 ||
+            (dot != NULL &&
+             strcasecmp(priorities[i].c_str(), dot + 1) == 0))
+            return i;
+
+    return priorities.size();
+}
+
+void
+DedupeTurnPointReader::add(TurnPointReader &reader,
+                           const std::string &source)
+{
+    const unsigned rank = getRank(source);
+
+    points.load(reader);
+    ranks.resize(points.size(), rank);
+}
+
+void
+DedupeTurnPointReader::merge()
+{
+    const Distance distance(Distance::UNIT_METERS, radius);
+
+    /* the turn points with the best priority are kept, the others
+       are merged into them */
+    std::vector<unsigned> order(points.size());
+    for (unsigned i = 0; i < order.size(); ++i)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(), DedupeCompareRank(ranks));
+
+    DedupeGrid grid(chordLength(distance), points.size());
+    std::vector<bool> kept(points.size(), false);
+
+    for (std::vector<unsigned>::const_iterator it = order.begin();
+         it != order.end(); ++it) {
+        const TurnPointTable::Record &record = points[*it];
+        const PreparedPosition prepared(record.position);
+
+        if (!prepared.defined()) {
+            /* no position: can't compare it */
+            kept[*it] = true;
+            continue;
+        }
+
+        DedupeCompatible compatible(points, record.type);
+        int found = grid.findNearest(prepared, distance, compatible);
+        if (found >= 0) {
+            merge_attributes(points[found], record);
+        } else {
+            kept[*it] = true;
+            grid.add(*it, prepared);
+        }
+    }
+
+    for (unsigned i = 0; i < points.size(); ++i)
+        if (kept[i])
+            result.push_back(i);
+
+    merged = true;
+}
+
+bool
+DedupeTurnPointReader::read_into(TurnPoint &tp)
+{
+    if (!merged)
+        merge();
+
+    if (position >= result.size())
+        return false;
+
+    points.get(result[position++], tp);
+    return true;
+}
+
+TurnPointReader *
+DedupeTurnPointFilter::createFilter(TurnPointReader *reader,
+                                    const char *args) const
+{
+    DedupeTurnPointReader *dedupe = new DedupeTurnPointReader(args);
+
+    try {
+        dedupe->add(*reader, std::string());
+    } catch (...) {
+        delete dedupe;
+        throw;
+    }
+
+    delete reader;
+    return dedupe;
+}
+
+unsigned
+DedupeTurnPointFilter::getFields() const
+{
+    return TurnPoint::FIELD_POSITION | TurnPoint::FIELD_TYPE;
+}
@@ -0,0 +1,80 @@
+/*
+ * loggertools
+ * Copyright (C) 2004-2008 Max Kellermann <max@duempel.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; version 2 of the License
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+#ifndef __LOGGERTOOLS_TP_DEDUPE_HH
+#define __LOGGERTOOLS_TP_DEDUPE_HH
+
+#include "tp.hh"
+#include "tp-io.hh"
+#include "tp-table.hh"
+
+#include <string>
+#include <vector>
+
+/**
+ * A reader which merges turn points which are closer than a radius
+ * and have compatible types.  The turn points may come from several
+ * sources; the one with the highest priority determines the position,
+ * and the others only fill attributes which it does not have.  Near
+ * turn points are found with a hash grid over the unit vectors, so
+ * each turn point is only compared with a few others.
+ *
+ * The turn points are returned in the order in which they were read,
+ * without the duplicates.
+ */
+class DedupeTurnPointReader : public TurnPointRecordReader {
+private:
+    double radius;
+
+    /** the source names in the order of their priority */
+    std::vector<std::string> priorities;
+
+    TurnPointTable points;
+    /** the priority of each turn point; lower is better */
+    std::vector<unsigned> ranks;
+
+    bool merged;
+    /** the numbers of the turn points which are returned */
+    std::vector<unsigned> result;
+    size_t position;
+
+public:
+    /**
+     * @param args "RADIUS" or "RADIUS:SOURCE1,SOURCE2,..."; a source
+     * is matched with the name or the filename extension passed to
+     * add()
+     */
+    DedupeTurnPointReader(const char *args);
+
+public:
+    /**
+     * Load all turn points from the reader (without deleting it).
+     * Sources which are not in the priority list come after those
+     * which are, in the order in which they were added.
+     */
+    void add(TurnPointReader &reader, const std::string &source);
+
+private:
+    unsigned getRank(const std::string &source) const;
+    void merge();
+
+public:
+    virtual bool read_into(TurnPoint &tp);
+};
+
+#endif
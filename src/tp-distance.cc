@@ -20,8 +20,10 @@
 #include "exception.hh"
 #include "tp.hh"
 #include "tp-io.hh"
+#include "tp-index.hh"
+#include "tp-constraint.hh"
 #include "io-compare.hh"
-#include "io-match.hh"
+#include "io-predicate.hh"
 #include "earth-parser.hh"
 
 #include <string.h>
@@ -35,21 +37,24 @@ public:
 
 public:
     bool operator ()(const TurnPoint &tp) {
-        return tp.getCode() == name || tp.getShortName() == name ||
-            tp.getFullName() == name;
+        return tp.hasName(name);
     }
 };
 
 class TurnPointCompareDistance {
     Distance distance;
+    SurfaceCircle circle;
 
 public:
     TurnPointCompareDistance(const Distance &_distance)
-        :distance(_distance) {}
+        :distance(_distance), circle(SurfacePosition(), _distance) {}
 
 public:
     bool operator ()(const TurnPoint &reference, const TurnPoint &tp) {
-        return tp.getPosition() - reference.getPosition() <= distance;
+        if (!(circle.getCenter() == reference.getPosition()))
+            circle = SurfaceCircle(reference.getPosition(), distance);
+
+        return circle.contains(tp.getPosition());
     }
 };
 
@@ -57,23 +62,54 @@ typedef FindCompareReader<TurnPoint, TurnPointFindByName,
                           TurnPointCompareDistance>
 NameDistanceTurnPointReader;
 
-class TurnPointMatchDistance {
-    const SurfacePosition center;
-    const Distance distance;
+class DistanceTurnPointPredicate : public TurnPointPredicate {
+    const SurfaceCircle circle;
 
 public:
-    TurnPointMatchDistance(const SurfacePosition &_center,
-                           const Distance &_distance)
-        :center(_center), distance(_distance) {}
+    DistanceTurnPointPredicate(const SurfacePosition &center,
+                               const Distance &distance)
+        :circle(center, distance) {}
 
 public:
-    bool operator ()(const TurnPoint &tp) {
-        return tp.getPosition() - center <= distance;
+    virtual unsigned getCost() const {
+        return 2;
+    }
+
+    virtual bool match(const TurnPoint &tp) const {
+        return circle.contains(tp.getPosition());
+    }
+
+    virtual bool constrain(TurnPointConstraint &constraint) const {
+        constraint.addCircle(circle);
+        return true;
     }
 };
 
-typedef MatchReader<TurnPoint, TurnPointMatchDistance>
-DistanceTurnPointReader;
+TurnPointPredicate *
+DistanceTurnPointFilter::createPredicate(const char *args) const {
+    if (args == NULL || *args == 0)
+        throw malformed_input("No maximum distance provided");
+
+    const char *p = args;
+    Position center;
+    try {
+         center = parsePosition(p);
+    } catch (const malformed_input &e) {
+        /* the center is the position of a named turn point, which
+           has to be looked up in the stream */
+        return NULL;
+    }
+
+    if (*p != ':')
+        throw malformed_input("Radius is missing");
+
+    return new DistanceTurnPointPredicate(center, parseDistance(p + 1));
+}
+
+unsigned
+DistanceTurnPointFilter::getFields() const {
+    return TurnPoint::FIELD_NAMES | TurnPoint::FIELD_POSITION;
+}
 
 TurnPointReader *
 DistanceTurnPointFilter::createFilter(TurnPointReader *reader,
@@ -81,9 +117,16 @@ DistanceTurnPointFilter::createFilter(TurnPointReader *reader,
     if (args == NULL || *args == 0)
         throw malformed_input("No maximum distance provided");
 
+    /* if the input has been loaded into an index (tpconv does that
+       when there are several distance filters), narrow its selection
+       instead of checking each turn point */
+    IndexedTurnPointReader *indexed =
+        dynamic_cast<IndexedTurnPointReader*>(reader);
+
+    const char *p = args;
     Position center;
     try {
-         center = parsePosition(args);
+         center = parsePosition(p);
     } catch (const malformed_input &e) {
         const char *colon = strchr(args, ':');
         if (colon == NULL)
@@ -91,18 +134,45 @@ DistanceTurnPointFilter::createFilter(TurnPointReader *reader,
 
         std::string name(args, colon - args);
         Distance radius = parseDistance(colon + 1);
+
+        if (indexed != NULL) {
+            const TurnPointIndex &index = indexed->getIndex();
+            TurnPointIndex::ResultList result;
+            TurnPointIndex::ResultList::const_iterator it;
+
+            index.findName(name, result);
+            for (it = result.begin(); it != result.end(); ++it)
+                if (indexed->isSelected(*it))
+                    break;
+
+            if (it == result.end())
+                throw malformed_input("reference item not found");
+
+            center = index.getPosition(*it);
+            result.clear();
+            index.query(center, radius, result);
+            indexed->select(result);
+            return reader;
+        }
+
         return new NameDistanceTurnPointReader(reader,
                                                TurnPointFindByName(name),
                                                TurnPointCompareDistance(radius));
     }
 
-    Distance radius = parseDistance(args);
+    if (*p != ':')
+        throw malformed_input("Radius is missing");
+
+    Distance radius = parseDistance(p + 1);
 
-    /*
-    if (*p != 0)
-        throw malformed_input("malformed trailing input");
-    */
+    if (indexed != NULL) {
+        TurnPointIndex::ResultList result;
+        indexed->getIndex().query(center, radius, result);
+        indexed->select(result);
+        return reader;
+    }
 
-    return new DistanceTurnPointReader(reader,
-                                       TurnPointMatchDistance(center, radius));
+    return new PredicateReader<TurnPoint>(reader,
+                                          new DistanceTurnPointPredicate(center,
+                                                                         radius));
 }
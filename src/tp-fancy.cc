@@ -35,6 +35,7 @@ public:
 public:
     virtual void write(const TurnPoint &tp);
     virtual void flush();
+    virtual unsigned getFields() const;
 };
 
 FancyTurnPointWriter::FancyTurnPointWriter(std::ostream *_stream)
@@ -309,6 +310,10 @@ void FancyTurnPointWriter::flush() {
     stream = NULL;
 }
 
+unsigned FancyTurnPointWriter::getFields() const {
+    return TurnPoint::FIELD_ALL & ~TurnPoint::FIELD_DESCRIPTION;
+}
+
 TurnPointReader *
 FancyTurnPointFormat::createReader(std::istream *) const {
     return NULL;
@@ -21,18 +21,21 @@
 
 #include "tp.hh"
 #include "tp-io.hh"
+#include "tp-constraint.hh"
 #include "filser.h"
 
 #include <istream>
 
-class FilserTurnPointReader : public TurnPointReader {
+class FilserTurnPointReader : public TurnPointRecordReader {
 private:
     std::istream *stream;
     unsigned count;
+    ReaderPredicate predicate;
 public:
     FilserTurnPointReader(std::istream *stream);
 public:
-    virtual const TurnPoint *read();
+    virtual bool setPredicate(Predicate<TurnPoint> *_predicate);
+    virtual bool read_into(TurnPoint &tp);
 };
 
 FilserTurnPointReader::FilserTurnPointReader(std::istream *_stream)
@@ -69,42 +72,63 @@ static Runway::type_t convertRunwayType(char ch) {
         return Runway::TYPE_UNKNOWN;
 }
 
-const TurnPoint *FilserTurnPointReader::read() {
+bool
+FilserTurnPointReader::setPredicate(Predicate<TurnPoint> *_predicate)
+{
+    if (count > 0)
+        return false;
+
+    return predicate.set(_predicate);
+}
+
+bool FilserTurnPointReader::read_into(TurnPoint &tp) {
     struct filser_turn_point data;
-    TurnPoint *tp;
     size_t length;
+    const TurnPointConstraint &constraint = predicate.getConstraint();
 
-    do {
+    while (true) {
         if (count >= 600 || stream->eof())
-            return NULL;
+            return false;
 
         stream->read((char*)&data, sizeof(data));
         count++;
-    } while (data.valid == 0);
 
-    /* create object */
-    tp = new TurnPoint();
+        if (data.valid == 0)
+            continue;
+
+        /* check the position before the strings are copied; this
+           format has no type */
+        const SurfacePosition position(convertAngle<Latitude>(data.latitude),
+                                       convertAngle<Longitude>(data.longitude));
+        if (!constraint.matchType(TurnPoint::TYPE_UNKNOWN) ||
+            !constraint.matchPosition(position))
+            continue;
+
+        /* fill object */
+        tp.clear();
 
-    /* extract code */
-    length = sizeof(data.code);
-    while (length > 0 && data.code[length - 1] >= 0 &&
-           data.code[length - 1] <= ' ')
-        length--;
+        /* extract code */
+        length = sizeof(data.code);
+        while (length > 0 && data.code[length - 1] >= 0 &&
+               data.code[length - 1] <= ' ')
+            length--;
 
-    if (length > 0)
-        tp->setShortName(std::string(data.code, 0, length));
+        if (length > 0)
+            tp.setShortName(std::string(data.code, 0, length));
 
-    tp->setPosition(Position(convertAngle<Latitude>(data.latitude),
-                             convertAngle<Longitude>(data.longitude),
-                             Altitude(ntohs(data.altitude_ft), Altitude::UNIT_FEET, Altitude::REF_MSL)));
+        tp.setPosition(Position(position.getLatitude(),
+                                position.getLongitude(),
+                                Altitude(ntohs(data.altitude_ft), Altitude::UNIT_FEET, Altitude::REF_MSL)));
 
-    tp->setFrequency(convertFrequency(data.frequency));
+        tp.setFrequency(convertFrequency(data.frequency));
 
-    tp->setRunway(Runway(convertRunwayType(data.runway_type),
-                         data.runway_direction >= 1 && data.runway_direction <= 36 ? data.runway_direction : (unsigned)Runway::DIRECTION_UNDEFINED,
-                         (unsigned)(ntohs(data.runway_length_ft) / 3.28)));
+        tp.setRunway(Runway(convertRunwayType(data.runway_type),
+                             data.runway_direction >= 1 && data.runway_direction <= 36 ? data.runway_direction : (unsigned)Runway::DIRECTION_UNDEFINED,
+                             (unsigned)(ntohs(data.runway_length_ft) / 3.28)));
 
-    return tp;
+        if (predicate.match(tp))
+            return true;
+    }
 }
 
 TurnPointReader *
@@ -36,6 +36,7 @@ public:
 public:
     virtual void write(const TurnPoint &tp);
     virtual void flush();
+    virtual unsigned getFields() const;
 };
 
 FilserTurnPointWriter::FilserTurnPointWriter(std::ostream *_stream)
@@ -142,6 +143,11 @@ void FilserTurnPointWriter::flush() {
     stream = NULL;
 }
 
+unsigned FilserTurnPointWriter::getFields() const {
+    return TurnPoint::FIELD_NAMES | TurnPoint::FIELD_POSITION |
+        TurnPoint::FIELD_RUNWAY;
+}
+
 TurnPointWriter *
 FilserTurnPointFormat::createWriter(std::ostream *stream) const {
     return new FilserTurnPointWriter(stream);
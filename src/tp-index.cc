@@ -0,0 +1,361 @@
+/*
+ * loggertools
+ * Copyright (C) 2004-2008 Max Kellermann <max@duempel.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; version 2 of the License
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include "tp-index.hh"
+
+#include <algorithm>
+#include <iterator>
+
+#include <math.h>
+
+
+/** the desired average number of turn points per grid cell */
+static const unsigned POINTS_PER_CELL = 8;
+
+/** the maximum number of rows and columns of the grid */
+static const unsigned MAX_GRID_SIZE = 1024;
+
+static const Angle::value_t MAX_LATITUDE = 90 * 60 * 1000;
+static const Angle::value_t MAX_LONGITUDE = 180 * 60 * 1000;
+
+/**
+ * Can this position be stored in the grid?  Others are not in the
+ * grid, and are checked one by one.
+ */
+static bool
+indexable(const SurfacePosition &position)
+{
+    return position.defined() &&
+        position.getLatitude().getValue() >= -MAX_LATITUDE &&
+        position.getLatitude().getValue() <= MAX_LATITUDE &&
+        position.getLongitude().getValue() >= -MAX_LONGITUDE &&
+        position.getLongitude().getValue() <= MAX_LONGITUDE;
+}
+
+TurnPointIndex::TurnPointIndex()
+    :min_latitude(0), max_latitude(0),
+     min_longitude(0), max_longitude(0),
+     rows(0), columns(0) {}
+
+void
+TurnPointIndex::load(TurnPointReader &reader)
+{
+    points.load(reader);
+
+    build();
+    buildNames();
+}
+
+unsigned
+TurnPointIndex::getRow(Angle::value_t latitude) const
+{
+    return (unsigned)(((long long)latitude - min_latitude) * rows /
+                      ((long long)max_latitude - min_latitude + 1));
+}
+
+unsigned
+TurnPointIndex::getColumn(Angle::value_t longitude) const
+{
+    return (unsigned)(((long long)longitude - min_longitude) * columns /
+                      ((long long)max_longitude - min_longitude + 1));
+}
+
+void
+TurnPointIndex::build()
+{
+    unsigned n = 0, i;
+
+    unindexed.clear();
+
+    /* determine the bounding box */
+
+    for (i = 0; i < points.size(); ++i) {
+        const SurfacePosition &position = points.getPosition(i);
+        if (!indexable(position)) {
+            unindexed.push_back(i);
+            continue;
+        }
+
+        Angle::value_t latitude = position.getLatitude().getValue();
+        Angle::value_t longitude = position.getLongitude().getValue();
+
+        if (n == 0 || latitude < min_latitude)
+            min_latitude = latitude;
+        if (n == 0 || latitude > max_latitude)
+            max_latitude = latitude;
+        if (n == 0 || longitude < min_longitude)
+            min_longitude = longitude;
+        if (n == 0 || longitude > max_longitude)
+            max_longitude = longitude;
+
+        ++n;
+    }
+
+    if (n == 0) {
+        rows = columns = 0;
+        cell_start.clear();
+        cell_points.clear();
+        return;
+    }
+
+    rows = (unsigned)ceil(sqrt((double)(n / POINTS_PER_CELL)));
+    if (rows < 1)
+        rows = 1;
+    else if (rows > MAX_GRID_SIZE)
+        rows = MAX_GRID_SIZE;
+    columns = rows;
+
+    /* sort the turn points into the cells (counting sort, which
+       keeps them in ascending order within each cell) */
+
+    std::vector<unsigned> cells(points.size());
+
+    cell_start.assign(rows * columns + 1, 0);
+    for (i = 0; i < points.size(); ++i) {
+        const SurfacePosition &position = points.getPosition(i);
+        if (!indexable(position))
+            continue;
+
+        cells[i] = getRow(position.getLatitude().getValue()) * columns +
+            getColumn(position.getLongitude().getValue());
+        ++cell_start[cells[i] + 1];
+    }
+
+    for (i = 1; i < cell_start.size(); ++i)
+        cell_start[i] += cell_start[i - 1];
+
+    std::vector<unsigned> fill(cell_start.begin(), cell_start.end() - 1);
+    cell_points.resize(n);
+    for (i = 0; i < points.size(); ++i)
+        if (indexable(points.getPosition(i)))
+            cell_points[fill[cells[i]]++] = i;
+
+    cell_positions.clear();
+    cell_positions.reserve(n);
+    for (i = 0; i < n; ++i)
+        cell_positions.append(points.getPosition(cell_points[i]));
+}
+
+/**
+ * Calls f(name) for each non-empty name of the turn point.
+ */
+template<class F>
+static void
+for_each_name(const TurnPointTable &table, size_t i, F &f)
+{
+    const TurnPointTable::Record &record = table[i];
+
+    if (record.code != StringPool::EMPTY)
+        f(table.getString(record.code));
+    if (record.short_name != StringPool::EMPTY)
+        f(table.getString(record.short_name));
+    if (record.full_name != StringPool::EMPTY)
+        f(table.getString(record.full_name));
+}
+
+struct NameCounter {
+    std::vector<unsigned> &start;
+    size_t num_buckets;
+
+    NameCounter(std::vector<unsigned> &_start)
+        :start(_start), num_buckets(_start.size() - 1) {}
+
+    void operator ()(const char *name) {
+        ++start[name_hash(name) % num_buckets + 1];
+    }
+};
+
+struct NameFiller {
+    std::vector<unsigned> &fill, &points;
+    unsigned i;
+
+    NameFiller(std::vector<unsigned> &_fill, std::vector<unsigned> &_points)
+        :fill(_fill), points(_points), i(0) {}
+
+    void operator ()(const char *name) {
+        points[fill[name_hash(name) % fill.size()]++] = i;
+    }
+};
+
+void
+TurnPointIndex::buildNames()
+{
+    unsigned i;
+
+    /* about one name per bucket */
+    name_start.assign(points.size() * 3 + 2, 0);
+
+    NameCounter counter(name_start);
+    for (i = 0; i < points.size(); ++i)
+        for_each_name(points, i, counter);
+
+    for (i = 1; i < name_start.size(); ++i)
+        name_start[i] += name_start[i - 1];
+
+    std::vector<unsigned> fill(name_start.begin(), name_start.end() - 1);
+    name_points.resize(name_start.back());
+
+    NameFiller filler(fill, name_points);
+    for (i = 0; i < points.size(); ++i) {
+        filler.i = i;
+        for_each_name(points, i, filler);
+    }
+}
+
+void
+TurnPointIndex::findName(const std::string &name, ResultList &result) const
+{
+    const size_t first = result.size();
+    const unsigned bucket = name_hash(name) % (name_start.size() - 1);
+
+    for (unsigned j = name_start[bucket]; j < name_start[bucket + 1]; ++j) {
+        unsigned i = name_points[j];
+
+        /* a turn point may be in the bucket more than once, but
+           then twice in a row */
+        if ((result.size() == first || result.back() != i) &&
+            points.hasName(i, name))
+            result.push_back(i);
+    }
+}
+
+void
+TurnPointIndex::queryBox(const SurfaceCircle &circle,
+                         Angle::value_t lon1, Angle::value_t lon2,
+                         ResultList &result) const
+{
+    Angle::value_t lat1 = circle.getMinLatitude();
+    Angle::value_t lat2 = circle.getMaxLatitude();
+
+    if (lat1 < min_latitude)
+        lat1 = min_latitude;
+    if (lat2 > max_latitude)
+        lat2 = max_latitude;
+    if (lon1 < min_longitude)
+        lon1 = min_longitude;
+    if (lon2 > max_longitude)
+        lon2 = max_longitude;
+
+    if (lat1 > lat2 || lon1 > lon2)
+        return;
+
+    unsigned row1 = getRow(lat1), row2 = getRow(lat2);
+    unsigned column1 = getColumn(lon1), column2 = getColumn(lon2);
+    std::vector<unsigned char> inside;
+
+    for (unsigned row = row1; row <= row2; ++row) {
+        /* the cells of one row are adjacent in cell_points */
+        const unsigned begin = cell_start[row * columns + column1];
+        const unsigned end = cell_start[row * columns + column2 + 1];
+
+        if (begin == end)
+            continue;
+
+        inside.resize(end - begin);
+        cell_positions.within(circle.getCenter(), circle.getRadius(),
+                              begin, end, &inside[0]);
+
+        for (unsigned j = begin; j < end; ++j)
+            if (inside[j - begin])
+                result.push_back(cell_points[j]);
+    }
+}
+
+void
+TurnPointIndex::query(const SurfacePosition &center, const Distance &radius,
+                      ResultList &result) const
+{
+    const size_t first = result.size();
+    const SurfaceCircle circle(center, radius);
+
+    if (!circle.isBounded()) {
+        /* no bounding box (e.g. a very large radius): check all turn
+           points */
+        for (unsigned i = 0; i < points.size(); ++i)
+            if (circle.contains(points.getPosition(i)))
+                result.push_back(i);
+        return;
+    }
+
+    for (ResultList::const_iterator it = unindexed.begin();
+         it != unindexed.end(); ++it)
+        if (circle.contains(points.getPosition(*it)))
+            result.push_back(*it);
+
+    if (rows > 0) {
+        if (circle.getMinLongitude() <= circle.getMaxLongitude()) {
+            queryBox(circle, circle.getMinLongitude(),
+                     circle.getMaxLongitude(), result);
+        } else {
+            /* wraps around at 180 degrees */
+            queryBox(circle, circle.getMinLongitude(), MAX_LONGITUDE,
+                     result);
+            queryBox(circle, -MAX_LONGITUDE, circle.getMaxLongitude(),
+                     result);
+        }
+    }
+
+    std::sort(result.begin() + first, result.end());
+}
+
+IndexedTurnPointReader::IndexedTurnPointReader(TurnPointReader *reader)
+    :loaded(new TurnPointIndex()), index(*loaded),
+     selected(false), position(0) {
+    try {
+        loaded->load(*reader);
+    } catch (...) {
+        delete loaded;
+        delete reader;
+        throw;
+    }
+
+    delete reader;
+}
+
+bool
+IndexedTurnPointReader::isSelected(unsigned i) const
+{
+    return !selected ||
+        std::binary_search(selection.begin(), selection.end(), i);
+}
+
+void
+IndexedTurnPointReader::select(TurnPointIndex::ResultList &result)
+{
+    if (selected) {
+        TurnPointIndex::ResultList intersection;
+        std::set_intersection(selection.begin(), selection.end(),
+                              result.begin(), result.end(),
+                              std::back_inserter(intersection));
+        selection.swap(intersection);
+    } else {
+        selection.swap(result);
+        selected = true;
+    }
+}
+
+bool
+IndexedTurnPointReader::read_into(TurnPoint &tp)
+{
+    if (position >= getSelectedCount())
+        return false;
+
+    getSelected(position++, tp);
+    return true;
+}
@@ -0,0 +1,198 @@
+/*
+ * loggertools
+ * Copyright (C) 2004-2008 Max Kellermann <max@duempel.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; version 2 of the License
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef __LOGGERTOOLS_TP_INDEX_HH
+#define __LOGGERTOOLS_TP_INDEX_HH
+
+#include "tp.hh"
+#include "tp-io.hh"
+#include "tp-table.hh"
+#include "earth-batch.hh"
+
+#include <string>
+#include <vector>
+
+#include <ctype.h>
+
+/**
+ * Calculate a hash of a turn point name, ignoring case.
+ */
+static inline unsigned
+name_hash(const char *name)
+{
+    unsigned hash = 2166136261u;
+
+    for (; *name != 0; ++name)
+        hash = (hash ^ (unsigned)tolower((unsigned char)*name)) * 16777619u;
+
+    return hash;
+}
+
+static inline unsigned
+name_hash(const std::string &name)
+{
+    return name_hash(name.c_str());
+}
+
+/**
+ * An in-memory copy of a turn point database with a lat/lon grid
+ * index, which answers radius queries without looking at every turn
+ * point, and a hash index of the names.
+ */
+class TurnPointIndex {
+public:
+    typedef std::vector<unsigned> ResultList;
+
+private:
+    TurnPointTable points;
+
+    /** the bounding box covered by the grid */
+    Angle::value_t min_latitude, max_latitude;
+    Angle::value_t min_longitude, max_longitude;
+    unsigned rows, columns;
+
+    /** cell n contains the turn points cell_points[cell_start[n]]
+        up to cell_points[cell_start[n + 1]] (exclusive) */
+    std::vector<unsigned> cell_start, cell_points;
+
+    /** the positions of the turn points in cell_points, in the same
+        order, so a range of cells can be checked with one
+        PositionBatch::within() call */
+    PositionBatch cell_positions;
+
+    /** turn points without a valid position; they are checked
+        one by one */
+    ResultList unindexed;
+
+    /** hash bucket n contains the turn points with a name (code,
+        short name or full name) whose hash modulo the number of
+        buckets is n, see name_hash(); the layout is the same as the
+        one of the grid cells */
+    std::vector<unsigned> name_start, name_points;
+
+public:
+    TurnPointIndex();
+
+    /**
+     * Load all turn points from the reader (without deleting it), and
+     * build the index.
+     */
+    void load(TurnPointReader &reader);
+
+    size_t size() const {
+        return points.size();
+    }
+
+    const Position &getPosition(size_t i) const {
+        return points.getPosition(i);
+    }
+
+    void get(size_t i, TurnPoint &dest) const {
+        points.get(i, dest);
+    }
+
+    /**
+     * Find all turn points with "tp.getPosition() - center <= radius",
+     * and append their numbers to "result" in ascending order.
+     */
+    void query(const SurfacePosition &center, const Distance &radius,
+               ResultList &result) const;
+
+    /**
+     * Find all turn points which have this name (see
+     * TurnPoint::hasName()), and append their numbers to "result" in
+     * ascending order.
+     */
+    void findName(const std::string &name, ResultList &result) const;
+
+private:
+    void build();
+    void buildNames();
+    unsigned getRow(Angle::value_t latitude) const;
+    unsigned getColumn(Angle::value_t longitude) const;
+    void queryBox(const SurfaceCircle &circle,
+                  Angle::value_t lon1, Angle::value_t lon2,
+                  ResultList &result) const;
+};
+
+/**
+ * A reader which returns turn points from a TurnPointIndex.  By
+ * default, it returns all of them; select() narrows the selection.
+ */
+class IndexedTurnPointReader : public TurnPointRecordReader {
+private:
+    /** the index loaded by this object; NULL if it is shared */
+    TurnPointIndex *loaded;
+    const TurnPointIndex &index;
+    bool selected;
+    TurnPointIndex::ResultList selection;
+    size_t position;
+
+public:
+    /**
+     * Load all turn points from the specified reader, and delete it.
+     */
+    IndexedTurnPointReader(TurnPointReader *reader);
+
+    /**
+     * Return the turn points of an index which is owned by the
+     * caller.  Several readers may share one index, each with its
+     * own selection.
+     */
+    IndexedTurnPointReader(const TurnPointIndex &_index)
+        :loaded(NULL), index(_index), selected(false), position(0) {}
+
+    virtual ~IndexedTurnPointReader() {
+        delete loaded;
+    }
+
+private:
+    /* no copying */
+    IndexedTurnPointReader(const IndexedTurnPointReader &);
+    IndexedTurnPointReader &operator =(const IndexedTurnPointReader &);
+
+public:
+    const TurnPointIndex &getIndex() const {
+        return index;
+    }
+
+    /**
+     * Is the turn point with this number (in the index) selected?
+     */
+    bool isSelected(unsigned i) const;
+
+    size_t getSelectedCount() const {
+        return selected ? selection.size() : index.size();
+    }
+
+    void getSelected(size_t i, TurnPoint &dest) const {
+        index.get(selected ? selection[i] : i, dest);
+    }
+
+    /**
+     * Remove all turn points from the selection which are not in the
+     * specified list (which must be sorted).
+     */
+    void select(TurnPointIndex::ResultList &result);
+
+public:
+    virtual bool read_into(TurnPoint &tp);
+};
+
+#endif
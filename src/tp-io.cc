@@ -30,6 +30,7 @@ static const CenfisDatabaseFormat cenfisDatabaseFormat;
 static const CenfisHexTurnPointFormat cenfisHexFormat;
 static const FilserTurnPointFormat filserFormat;
 static const ZanderTurnPointFormat zanderFormat;
+static const BinaryTurnPointFormat binaryFormat;
 
 const TurnPointFormat *getTurnPointFormat(const char *ext) {
     if (strcasecmp(ext, "fancy") == 0)
@@ -49,6 +50,8 @@ const TurnPointFormat *getTurnPointFormat(const char *ext) {
         return &filserFormat;
     else if (strcasecmp(ext, "wz") == 0)
         return &zanderFormat;
+    else if (strcasecmp(ext, "tpb") == 0)
+        return &binaryFormat;
     else
         return NULL;
 }
@@ -56,6 +59,10 @@ const TurnPointFormat *getTurnPointFormat(const char *ext) {
 static const DistanceTurnPointFilter distanceFilter;
 static const AirfieldTurnPointFilter airfieldFilter;
 static const NameTurnPointFilter nameFilter;
+static const NearestTurnPointFilter nearestFilter;
+static const DedupeTurnPointFilter dedupeFilter;
+static const AirspaceTurnPointFilter airspaceFilter;
+static const OrderTurnPointFilter orderFilter;
 
 const TurnPointFilter *getTurnPointFilter(const char *name) {
     if (strcmp(name, "distance") == 0)
@@ -64,6 +71,14 @@ const TurnPointFilter *getTurnPointFilter(const char *name) {
         return &airfieldFilter;
     else if (strcmp(name, "name") == 0)
         return &nameFilter;
+    else if (strcmp(name, "nearest") == 0)
+        return &nearestFilter;
+    else if (strcmp(name, "dedupe") == 0)
+        return &dedupeFilter;
+    else if (strcmp(name, "airspace") == 0)
+        return &airspaceFilter;
+    else if (strcmp(name, "order") == 0)
+        return &orderFilter;
     else
         return NULL;
 }
@@ -23,10 +23,32 @@
 #include "io.hh"
 
 typedef Reader<TurnPoint> TurnPointReader;
+typedef RecordReader<TurnPoint> TurnPointRecordReader;
 typedef Writer<TurnPoint> TurnPointWriter;
 typedef Format<TurnPoint> TurnPointFormat;
 typedef Filter<TurnPoint> TurnPointFilter;
 
+class TurnPointConstraint;
+
+/**
+ * A predicate on turn points which can describe itself with a
+ * TurnPointConstraint, so readers are able to check it on their raw
+ * records.
+ */
+class TurnPointPredicate : public Predicate<TurnPoint> {
+public:
+    /**
+     * Add the conditions of this predicate to the constraint.
+     *
+     * @return true if the constraint describes this predicate
+     * completely, false if match() must be checked anyway
+     */
+    virtual bool constrain(TurnPointConstraint &constraint) const {
+        (void)constraint;
+        return false;
+    }
+};
+
 class FancyTurnPointFormat : public TurnPointFormat {
 public:
     virtual TurnPointReader *createReader(std::istream *stream) const;
@@ -43,6 +65,7 @@ class SeeYouTurnPointFormat : public TurnPointFormat {
 public:
     virtual TurnPointReader *createReader(std::istream *stream) const;
     virtual TurnPointWriter *createWriter(std::ostream *stream) const;
+    virtual TurnPointReader *createFileReader(const char *path) const;
 };
 
 class CenfisTurnPointFormat : public TurnPointFormat {
@@ -75,6 +98,16 @@ public:
     virtual TurnPointWriter *createWriter(std::ostream *stream) const;
 };
 
+/**
+ * The lossless binary format of loggertools, see tp-binary.hh.
+ */
+class BinaryTurnPointFormat : public TurnPointFormat {
+public:
+    virtual TurnPointReader *createReader(std::istream *stream) const;
+    virtual TurnPointWriter *createWriter(std::ostream *stream) const;
+    virtual TurnPointReader *createFileReader(const char *path) const;
+};
+
 const TurnPointFormat *getTurnPointFormat(const char *ext);
 
 
@@ -82,18 +115,66 @@ class DistanceTurnPointFilter : public TurnPointFilter {
 public:
     virtual TurnPointReader *createFilter(TurnPointReader *reader,
                                           const char *args) const;
+    virtual TurnPointPredicate *createPredicate(const char *args) const;
+    virtual unsigned getFields() const;
 };
 
 class AirfieldTurnPointFilter : public TurnPointFilter {
 public:
     virtual TurnPointReader *createFilter(TurnPointReader *reader,
                                           const char *args) const;
+    virtual TurnPointPredicate *createPredicate(const char *args) const;
+    virtual unsigned getFields() const;
 };
 
 class NameTurnPointFilter : public TurnPointFilter {
 public:
     virtual TurnPointReader *createFilter(TurnPointReader *reader,
                                           const char *args) const;
+    virtual TurnPointPredicate *createPredicate(const char *args) const;
+    virtual unsigned getFields() const;
+};
+
+class NearestTurnPointFilter : public TurnPointFilter {
+public:
+    virtual TurnPointReader *createFilter(TurnPointReader *reader,
+                                          const char *args) const;
+    virtual unsigned getFields() const;
+};
+
+/**
+ * Keeps the turn points outside (or inside) the airspaces of an
+ * OpenAir file.
+ */
+class AirspaceTurnPointFilter : public TurnPointFilter {
+public:
+    virtual TurnPointReader *createFilter(TurnPointReader *reader,
+                                          const char *args) const;
+    virtual TurnPointPredicate *createPredicate(const char *args) const;
+    virtual unsigned getFields() const;
+};
+
+/**
+ * Merges turn points which are closer than a radius.  tpconv applies
+ * it to all input files together, see DedupeTurnPointReader.
+ */
+class DedupeTurnPointFilter : public TurnPointFilter {
+public:
+    virtual TurnPointReader *createFilter(TurnPointReader *reader,
+                                          const char *args) const;
+    virtual unsigned getFields() const;
+};
+
+/**
+ * Sorts the turn points by their position on a Hilbert curve
+ * ("order:hilbert"), or by name ("order:name").  tpconv applies it
+ * to all input files together, see OrderTurnPointReader.
+ */
+class OrderTurnPointFilter : public TurnPointFilter {
+public:
+    virtual TurnPointReader *createFilter(TurnPointReader *reader,
+                                          const char *args) const;
+    virtual unsigned getFields() const;
 };
 
 const TurnPointFilter *getTurnPointFilter(const char *name);
@@ -26,17 +26,23 @@
 #include <stdlib.h>
 #include <string.h>
 
-class MilomeiTurnPointReader : public TurnPointReader {
+class MilomeiTurnPointReader : public TurnPointRecordReader {
 private:
     std::istream *stream;
+    /** the fields which are parsed, see setFields() */
+    unsigned fields;
+    /** the full name; it is needed to guess the type, even if it
+        is not stored in the TurnPoint */
+    std::string name;
 public:
     MilomeiTurnPointReader(std::istream *stream);
 public:
-    virtual const TurnPoint *read();
+    virtual void setFields(unsigned _fields);
+    virtual bool read_into(TurnPoint &tp);
 };
 
 MilomeiTurnPointReader::MilomeiTurnPointReader(std::istream *_stream)
-    :stream(_stream) {}
+    :stream(_stream), fields(TurnPoint::FIELD_ALL) {}
 
 static bool
 is_whitespace(char ch)
@@ -53,6 +59,15 @@ stripped_substring(const char *p, size_t length)
     return std::string(p, length);
 }
 
+static void
+stripped_substring(std::string &dest, const char *p, size_t length)
+{
+    while (is_whitespace(p[length - 1]))
+        --length;
+
+    dest.assign(p, length);
+}
+
 static Altitude
 parse_altitude(const std::string &s)
 {
@@ -222,8 +237,8 @@ word_match(const std::string &s, const char *begin,
     return 0;
 }
 
-const TurnPoint *
-MilomeiTurnPointReader::read()
+bool
+MilomeiTurnPointReader::read_into(TurnPoint &tp)
 {
     char line[1024];
 
@@ -232,15 +247,16 @@ MilomeiTurnPointReader::read()
             stream->getline(line, sizeof(line));
         } catch (const std::ios_base::failure &e) {
             if (stream->eof())
-                return NULL;
+                return false;
             else
                 throw;
         }
     } while (line[0] == '$' || strlen(line) < 64);
 
-    TurnPoint tp;
+    tp.clear();
 
-    tp.setShortName(stripped_substring(line, 6));
+    if (fields & TurnPoint::FIELD_SHORT_NAME)
+        tp.setShortName(stripped_substring(line, 6));
 
     if (memcmp(line + 23, "# S", 3) == 0 ||
              memcmp(line + 20, "GLD#", 4) == 0)
@@ -252,91 +268,110 @@ MilomeiTurnPointReader::read()
     else if (line[23] == '*')
         tp.setType(TurnPoint::TYPE_OUTLANDING);
 
-    if (line[23] == '#' || line[23] == '*')
-        tp.setFullName(stripped_substring(line + 7, 16));
-    else
-        tp.setFullName(stripped_substring(line + 7, 34));
+    if (fields & (TurnPoint::FIELD_FULL_NAME | TurnPoint::FIELD_TYPE)) {
+        if (line[23] == '#' || line[23] == '*')
+            stripped_substring(name, line + 7, 16);
+        else
+            stripped_substring(name, line + 7, 34);
+
+        if (fields & TurnPoint::FIELD_FULL_NAME)
+            tp.setFullName(name);
+    } else
+        name.clear();
 
-    if ((line[23] == '#' || (line[23] == '*' && line[24] != 'U')) &&
+    if ((fields & TurnPoint::FIELD_CODE) &&
+        (line[23] == '#' || (line[23] == '*' && line[24] != 'U')) &&
         line[24] != ' ')
         tp.setCode(stripped_substring(line + 24, 4));
 
-    Altitude altitude = parse_altitude(std::string(line + 41, 4));
-    Latitude latitude = parseAngle<Latitude,'S','N'>(std::string(line + 45, 7));
-    Longitude longitude = parseAngle<Longitude,'W','E'>(std::string(line + 52, 8));
+    if (fields & TurnPoint::FIELD_POSITION) {
+        Altitude altitude = parse_altitude(std::string(line + 41, 4));
+        Latitude latitude = parseAngle<Latitude,'S','N'>(std::string(line + 45, 7));
+        Longitude longitude = parseAngle<Longitude,'W','E'>(std::string(line + 52, 8));
 
-    tp.setPosition(Position(latitude, longitude, altitude));
+        tp.setPosition(Position(latitude, longitude, altitude));
+    }
 
     if (line[23] == '#' || memcmp(line + 23, "*ULM", 4) == 0) {
-        tp.setRunway(parse_runway(line + 28));
-        tp.setFrequency(parse_frequency(std::string(line + 36, 5)));
+        if (fields & TurnPoint::FIELD_RUNWAY)
+            tp.setRunway(parse_runway(line + 28));
+        if (fields & TurnPoint::FIELD_FREQUENCY)
+            tp.setFrequency(parse_frequency(std::string(line + 36, 5)));
     }
 
-    if (tp.getType() == TurnPoint::TYPE_UNKNOWN) {
-        if (word_match(tp.getFullName(), "TV", check_exact) ||
-            word_match(tp.getFullName(), "SENDER", check_exact))
+    /* guess the type from words in the name */
+    if ((fields & TurnPoint::FIELD_TYPE) &&
+        tp.getType() == TurnPoint::TYPE_UNKNOWN) {
+        if (word_match(name, "TV", check_exact) ||
+            word_match(name, "SENDER", check_exact))
             tp.setType(TurnPoint::TYPE_SENDER);
-        else if (word_match(tp.getFullName(), "BR", check_exact))
+        else if (word_match(name, "BR", check_exact))
             tp.setType(TurnPoint::TYPE_BRIDGE);
-        else if (word_match(tp.getFullName(), "EX", check_exact) ||
-                 word_match(tp.getFullName(), "EY", check_exact))
+        else if (word_match(name, "EX", check_exact) ||
+                 word_match(name, "EY", check_exact))
             tp.setType(TurnPoint::TYPE_RAILWAY_INTERSECTION);
-        else if (word_match(tp.getFullName(), "BF", check_exact) ||
-                 word_match(tp.getFullName(), "RS", check_exact) ||
-                 word_match(tp.getFullName(), "GARE", check_exact))
+        else if (word_match(name, "BF", check_exact) ||
+                 word_match(name, "RS", check_exact) ||
+                 word_match(name, "GARE", check_exact))
             tp.setType(TurnPoint::TYPE_RAILWAY_STATION);
-        else if (word_match(tp.getFullName(), "KIRCHE", check_exact) ||
-                 word_match(tp.getFullName(), "EGLISE", check_exact) ||
-                 word_match(tp.getFullName(), "STIFTSKIRCHE", check_exact) ||
-                 word_match(tp.getFullName(), "KAPELLE", check_exact) ||
-                 word_match(tp.getFullName(), "KLOSTER", check_exact) ||
-                 word_match(tp.getFullName(), "KLOSTERKIRCHE", check_exact))
+        else if (word_match(name, "KIRCHE", check_exact) ||
+                 word_match(name, "EGLISE", check_exact) ||
+                 word_match(name, "STIFTSKIRCHE", check_exact) ||
+                 word_match(name, "KAPELLE", check_exact) ||
+                 word_match(name, "KLOSTER", check_exact) ||
+                 word_match(name, "KLOSTERKIRCHE", check_exact))
             tp.setType(TurnPoint::TYPE_CHURCH);
-        else if (word_match(tp.getFullName(), "SCHLOSS", check_exact) ||
-                 word_match(tp.getFullName(), "WASSERSCHLOSS", check_exact) ||
-                 word_match(tp.getFullName(), "FESTUNG", check_exact))
+        else if (word_match(name, "SCHLOSS", check_exact) ||
+                 word_match(name, "WASSERSCHLOSS", check_exact) ||
+                 word_match(name, "FESTUNG", check_exact))
             tp.setType(TurnPoint::TYPE_CASTLE);
-        else if (word_match(tp.getFullName(), "RUINE", check_exact))
+        else if (word_match(name, "RUINE", check_exact))
             tp.setType(TurnPoint::TYPE_RUIN);
-        else if (word_match(tp.getFullName(), "RESTAURANT", check_exact))
+        else if (word_match(name, "RESTAURANT", check_exact))
             tp.setType(TurnPoint::TYPE_BUILDING);
-        else if (word_match(tp.getFullName(), "GIPFEL", check_exact) ||
-                 word_match(tp.getFullName(), "GIPFELKREUZ", check_exact))
+        else if (word_match(name, "GIPFEL", check_exact) ||
+                 word_match(name, "GIPFELKREUZ", check_exact))
             tp.setType(TurnPoint::TYPE_MOUNTAIN_TOP);
-        else if (word_match(tp.getFullName(), "SEILBAHN", check_exact) ||
-                 word_match(tp.getFullName(), "SKILIFT", check_exact))
+        else if (word_match(name, "SEILBAHN", check_exact) ||
+                 word_match(name, "SKILIFT", check_exact))
             tp.setType(TurnPoint::TYPE_ROPEWAY);
-        else if (word_match(tp.getFullName(), "PASS", check_exact) ||
-                 word_match(tp.getFullName(), "PASSHOEHE", check_exact))
+        else if (word_match(name, "PASS", check_exact) ||
+                 word_match(name, "PASSHOEHE", check_exact))
             tp.setType(TurnPoint::TYPE_MOUNTAIN_PASS);
-        else if (word_match(tp.getFullName(), "TUNNEL", check_exact))
+        else if (word_match(name, "TUNNEL", check_exact))
             tp.setType(TurnPoint::TYPE_TUNNEL);
-        else if (word_match(tp.getFullName(), "STAUSEE", check_exact))
+        else if (word_match(name, "STAUSEE", check_exact))
             tp.setType(TurnPoint::TYPE_LAKE);
-        else if (word_match(tp.getFullName(), "STAUMAUER", check_exact) ||
-                 word_match(tp.getFullName(), "STAUDAMM", check_exact))
+        else if (word_match(name, "STAUMAUER", check_exact) ||
+                 word_match(name, "STAUDAMM", check_exact))
             tp.setType(TurnPoint::TYPE_DAM);
-        else if (word_match(tp.getFullName(), "SCHORNSTEIN", check_exact) ||
-                 word_match(tp.getFullName(), "SCHORNST", check_exact))
+        else if (word_match(name, "SCHORNSTEIN", check_exact) ||
+                 word_match(name, "SCHORNST", check_exact))
             tp.setType(TurnPoint::TYPE_CHIMNEY);
-        else if (word_match(tp.getFullName(), "KUEHLTURM", check_exact))
+        else if (word_match(name, "KUEHLTURM", check_exact))
             tp.setType(TurnPoint::TYPE_COOL_TOWER);
-        else if (word_match(tp.getFullName(), "SX", check_exact) ||
-                 word_match(tp.getFullName(), "SY", check_exact) ||
-                 word_match(tp.getFullName(), "B", check_highway_intersection))
+        else if (word_match(name, "SX", check_exact) ||
+                 word_match(name, "SY", check_exact) ||
+                 word_match(name, "B", check_highway_intersection))
             tp.setType(TurnPoint::TYPE_HIGHWAY_INTERSECTION);
-        else if (word_match(tp.getFullName(), "TR", check_exact))
+        else if (word_match(name, "TR", check_exact))
             tp.setType(TurnPoint::TYPE_GARAGE);
-        else if (word_match(tp.getFullName(), "BAB", check_highway_exit)) {
-            if (word_match(tp.getFullName(), "A", check_highway_intersection))
+        else if (word_match(name, "BAB", check_highway_exit)) {
+            if (word_match(name, "A", check_highway_intersection))
                 tp.setType(TurnPoint::TYPE_HIGHWAY_INTERSECTION);
             else
                 tp.setType(TurnPoint::TYPE_HIGHWAY_EXIT);
-        } else if (word_match(tp.getFullName(), "FOEHNWELLE", check_exact))
+        } else if (word_match(name, "FOEHNWELLE", check_exact))
             tp.setType(TurnPoint::TYPE_MOUNTAIN_WAVE);
     }
 
-    return new TurnPoint(tp);
+    return true;
+}
+
+void
+MilomeiTurnPointReader::setFields(unsigned _fields)
+{
+    fields = _fields;
 }
 
 TurnPointReader *
@@ -20,28 +20,128 @@
 #include "exception.hh"
 #include "tp.hh"
 #include "tp-io.hh"
-#include "io-match.hh"
+#include "tp-index.hh"
+#include "io-predicate.hh"
 
-class TurnPointMatchName {
-    std::string name;
+#include <algorithm>
+#include <utility>
+
+#include <string.h>
+
+/**
+ * Matches turn points which have one of the names in a list (see
+ * TurnPoint::hasName()).  The list is sorted by hash, so checking a
+ * turn point costs three binary searches, no matter how many names
+ * there are.
+ */
+class NameTurnPointPredicate : public TurnPointPredicate {
+    typedef std::pair<unsigned, std::string> Entry;
+    typedef std::vector<Entry> EntryList;
+
+    EntryList names;
 
 public:
-    TurnPointMatchName(const std::string &_name)
-        :name(_name) {}
+    NameTurnPointPredicate(const std::vector<std::string> &_names) {
+        for (std::vector<std::string>::const_iterator it = _names.begin();
+             it != _names.end(); ++it)
+            names.push_back(Entry(name_hash(*it), *it));
+
+        std::sort(names.begin(), names.end());
+    }
+
+private:
+    bool contains(const std::string &name) const {
+        if (name.empty())
+            return false;
+
+        const unsigned hash = name_hash(name);
+
+        for (EntryList::const_iterator it =
+                 std::lower_bound(names.begin(), names.end(),
+                                  Entry(hash, std::string()));
+             it != names.end() && it->first == hash; ++it)
+            if (strcasecmp(it->second.c_str(), name.c_str()) == 0)
+                return true;
+
+        return false;
+    }
 
 public:
-    bool operator ()(const TurnPoint &tp) {
-        return tp.getCode() == name || tp.getShortName() == name ||
-            tp.getFullName() == name;
+    virtual unsigned getCost() const {
+        return 3;
+    }
+
+    virtual bool match(const TurnPoint &tp) const {
+        return contains(tp.getCode()) || contains(tp.getShortName()) ||
+            contains(tp.getFullName());
     }
 };
 
+/**
+ * Parse the argument, a comma separated list of names.  A comma
+ * which is part of a name is written as "\,", a backslash before a
+ * comma as "\\".
+ */
+static void
+parse_names(const char *args, std::vector<std::string> &names)
+{
+    std::string name;
+
+    for (const char *p = args != NULL ? args : ""; ; ++p) {
+        if (*p == '\\' && (p[1] == ',' || p[1] == '\\')) {
+            name += *++p;
+        } else if (*p == ',' || *p == 0) {
+            if (!name.empty())
+                names.push_back(name);
+            name.clear();
+
+            if (*p == 0)
+                break;
+        } else
+            name += *p;
+    }
+
+    if (names.empty())
+        throw malformed_input("No name provided");
+}
+
+TurnPointPredicate *
+NameTurnPointFilter::createPredicate(const char *args) const {
+    std::vector<std::string> names;
+
+    parse_names(args, names);
+    return new NameTurnPointPredicate(names);
+}
+
+unsigned
+NameTurnPointFilter::getFields() const {
+    return TurnPoint::FIELD_NAMES;
+}
+
 TurnPointReader *
 NameTurnPointFilter::createFilter(TurnPointReader *reader,
                                   const char *args) const {
-    if (args == NULL || *args == 0)
-        throw malformed_input("No name provided");
+    /* if the input has been loaded into an index, look up the
+       names there */
+    IndexedTurnPointReader *indexed =
+        dynamic_cast<IndexedTurnPointReader*>(reader);
+    if (indexed != NULL) {
+        std::vector<std::string> names;
+        TurnPointIndex::ResultList result;
+
+        parse_names(args, names);
+
+        for (std::vector<std::string>::const_iterator it = names.begin();
+             it != names.end(); ++it)
+            indexed->getIndex().findName(*it, result);
+
+        std::sort(result.begin(), result.end());
+        result.erase(std::unique(result.begin(), result.end()),
+                     result.end());
+
+        indexed->select(result);
+        return reader;
+    }
 
-    return new MatchReader<TurnPoint, TurnPointMatchName>
-        (reader, TurnPointMatchName(args));
+    return new PredicateReader<TurnPoint>(reader, createPredicate(args));
 }
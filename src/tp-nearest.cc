@@ -0,0 +1,293 @@
+/*
+ * loggertools
+ * Copyright (C) 2004-2008 Max Kellermann <max@duempel.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; version 2 of the License
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+#include "exception.hh"
+#include "tp.hh"
+#include "tp-io.hh"
+#include "tp-index.hh"
+#include "earth-parser.hh"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <stdlib.h>
+#include <string.h>
+
+/** the radius of the first index query; it is doubled until enough
+    turn points are found */
+static const double FIRST_RADIUS = 10000.;
+
+/** with this radius, the query covers the whole earth */
+static const double MAX_RADIUS = 20100000.;
+
+/**
+ * Orders turn point numbers by their distance to a center, i.e. by
+ * the dot product of the unit vectors (descending).  Equal distances
+ * are ordered by number, so the result does not depend on the
+ * algorithm.
+ */
+class NearestCompare {
+    const std::vector<double> &dots;
+
+public:
+    NearestCompare(const std::vector<double> &_dots)
+        :dots(_dots) {}
+
+    bool operator ()(unsigned a, unsigned b) const {
+        return dots[a] > dots[b] || (!(dots[a] < dots[b]) && a < b);
+    }
+};
+
+/**
+ * Find the "count" turn points nearest to the center which have a
+ * position, are selected in the reader and match the predicate (if
+ * there is one), and append their numbers to "result".
+ *
+ * The radius of the index query is doubled until it returns enough
+ * candidates; the k nearest of them are then the k nearest of the
+ * whole index.  Only the candidates are partially sorted.
+ */
+static void
+find_nearest(const IndexedTurnPointReader &reader,
+             const SurfacePosition &center, unsigned count,
+             const Predicate<TurnPoint> *predicate,
+             TurnPointIndex::ResultList &result)
+{
+    const TurnPointIndex &index = reader.getIndex();
+    TurnPointIndex::ResultList candidates;
+    TurnPoint tp;
+    double radius = FIRST_RADIUS;
+
+    while (true) {
+        TurnPointIndex::ResultList found;
+        index.query(center, Distance(Distance::UNIT_METERS, radius), found);
+
+        candidates.clear();
+        for (TurnPointIndex::ResultList::const_iterator it = found.begin();
+             it != found.end(); ++it) {
+            /* the query over the whole earth returns the turn points
+               without a position, too */
+            if (!reader.isSelected(*it) ||
+                !index.getPosition(*it).defined())
+                continue;
+
+            if (predicate != NULL) {
+                index.get(*it, tp);
+                if (!predicate->match(tp))
+                    continue;
+            }
+
+            candidates.push_back(*it);
+        }
+
+        if (candidates.size() >= count || radius >= MAX_RADIUS)
+            break;
+
+        radius *= 2;
+    }
+
+    if (candidates.size() > count) {
+        const PreparedPosition prepared(center);
+        std::vector<double> dots(index.size());
+
+        for (TurnPointIndex::ResultList::const_iterator it = candidates.begin();
+             it != candidates.end(); ++it)
+            dots[*it] = prepared.dot(PreparedPosition(index.getPosition(*it)));
+
+        std::nth_element(candidates.begin(), candidates.begin() + count,
+                         candidates.end(), NearestCompare(dots));
+        candidates.resize(count);
+    }
+
+    result.insert(result.end(), candidates.begin(), candidates.end());
+}
+
+/**
+ * Parse the reference list: positions or turn point names, separated
+ * by commas.  The names are looked up in the reader, like
+ * TurnPointFindByName does in the distance filter.
+ */
+static void
+parse_references(const IndexedTurnPointReader &reader,
+                 const std::string &args,
+                 std::vector<SurfacePosition> &centers)
+{
+    std::string::size_type start = 0;
+
+    while (true) {
+        std::string::size_type comma = args.find(',', start);
+        const std::string reference =
+            args.substr(start, comma == std::string::npos
+                        ? std::string::npos : comma - start);
+
+        if (reference.empty())
+            throw malformed_input("Empty reference");
+
+        const char *p = reference.c_str();
+        try {
+            SurfacePosition center = parsePosition(p);
+            if (*p != 0)
+                throw malformed_input("Garbage after position");
+            centers.push_back(center);
+        } catch (const malformed_input &e) {
+            const TurnPointIndex &index = reader.getIndex();
+            TurnPointIndex::ResultList result;
+            TurnPointIndex::ResultList::const_iterator it;
+
+            index.findName(reference, result);
+            for (it = result.begin(); it != result.end(); ++it)
+                if (reader.isSelected(*it))
+                    break;
+
+            if (it == result.end())
+                throw malformed_input("reference item not found");
+
+            centers.push_back(index.getPosition(*it));
+        }
+
+        if (comma == std::string::npos)
+            break;
+        start = comma + 1;
+    }
+}
+
+/**
+ * Returns the turn points nearest to the references.  The input is
+ * loaded into a TurnPointIndex (unless it already is one) and the
+ * references are looked up on the first read, so errors are reported
+ * while reading, and the reader stays owned by the caller until the
+ * filter has been created.
+ */
+class NearestTurnPointReader : public TurnPointRecordReader {
+private:
+    TurnPointReader *reader;
+    IndexedTurnPointReader *indexed;
+    unsigned count;
+    std::string references;
+    Predicate<TurnPoint> *predicate;
+
+public:
+    NearestTurnPointReader(TurnPointReader *_reader, unsigned _count,
+                           const std::string &_references,
+                           Predicate<TurnPoint> *_predicate)
+        :reader(_reader), indexed(NULL), count(_count),
+         references(_references), predicate(_predicate) {}
+
+    virtual ~NearestTurnPointReader() {
+        delete predicate;
+        delete reader;
+    }
+
+private:
+    void select();
+
+public:
+    virtual bool read_into(TurnPoint &tp);
+};
+
+void
+NearestTurnPointReader::select()
+{
+    /* use the index if tpconv has already created one */
+    indexed = dynamic_cast<IndexedTurnPointReader*>(reader);
+    if (indexed == NULL) {
+        /* the IndexedTurnPointReader deletes the reader, even if it
+           fails */
+        TurnPointReader *input = reader;
+        reader = NULL;
+        indexed = new IndexedTurnPointReader(input);
+        reader = indexed;
+    }
+
+    std::vector<SurfacePosition> centers;
+    parse_references(*indexed, references, centers);
+
+    TurnPointIndex::ResultList result;
+    for (std::vector<SurfacePosition>::const_iterator it = centers.begin();
+         it != centers.end(); ++it)
+        find_nearest(*indexed, *it, count, predicate, result);
+
+    /* a turn point may be near to several references */
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    indexed->select(result);
+}
+
+bool
+NearestTurnPointReader::read_into(TurnPoint &tp)
+{
+    if (indexed == NULL)
+        select();
+
+    return indexed->read_into(tp);
+}
+
+TurnPointReader *
+NearestTurnPointFilter::createFilter(TurnPointReader *reader,
+                                     const char *args) const
+{
+    if (args == NULL || *args == 0)
+        throw malformed_input("No number provided");
+
+    char *endptr;
+    unsigned long count = strtoul(args, &endptr, 10);
+    if (endptr == args || count == 0)
+        throw malformed_input("Failed to parse the number");
+
+    if (*endptr != ':' || endptr[1] == 0)
+        throw malformed_input("No reference provided");
+
+    /* the references, and optionally a filter for the results
+       (e.g. "airfield") */
+    const char *references = endptr + 1;
+    const char *colon = strchr(references, ':');
+    Predicate<TurnPoint> *predicate = NULL;
+
+    if (colon != NULL) {
+        std::string name;
+        const char *filter_args = strchr(colon + 1, ':');
+        if (filter_args != NULL) {
+            name.assign(colon + 1, filter_args - colon - 1);
+            ++filter_args;
+        } else
+            name.assign(colon + 1);
+
+        const TurnPointFilter *filter = getTurnPointFilter(name.c_str());
+        if (filter == NULL)
+            throw malformed_input("Unknown filter");
+
+        predicate = filter->createPredicate(filter_args);
+        if (predicate == NULL)
+            throw malformed_input("This filter cannot be combined");
+    }
+
+    return new NearestTurnPointReader(reader, (unsigned)count,
+                                      colon != NULL
+                                      ? std::string(references,
+                                                    colon - references)
+                                      : std::string(references),
+                                      predicate);
+}
+
+unsigned
+NearestTurnPointFilter::getFields() const
+{
+    return TurnPoint::FIELD_NAMES | TurnPoint::FIELD_POSITION |
+        TurnPoint::FIELD_TYPE;
+}
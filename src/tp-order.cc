@@ -0,0 +1,230 @@
+/*
+ * loggertools
+ * Copyright (C) 2004-2008 Max Kellermann <max@duempel.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; version 2 of the License
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include "tp-order.hh"
+#include "exception.hh"
+#include "varint.hh"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+#include <ctype.h>
+#include <string.h>
+
+/** the number of bits of each coordinate of the Hilbert curve; an
+    Angle value (plus 180 degrees) fits into 25 bits */
+static const unsigned HILBERT_BITS = 25;
+
+static const Angle::value_t MAX_LATITUDE = 90 * 60 * 1000;
+static const Angle::value_t MAX_LONGITUDE = 180 * 60 * 1000;
+
+uint64_t
+hilbert_key(const SurfacePosition &position)
+{
+    if (!position.defined())
+        return ~(uint64_t)0;
+
+    Angle::value_t latitude = position.getLatitude().getValue();
+    Angle::value_t longitude = position.getLongitude().getValue();
+    if (latitude < -MAX_LATITUDE || latitude > MAX_LATITUDE ||
+        longitude < -MAX_LONGITUDE || longitude > MAX_LONGITUDE)
+        return ~(uint64_t)0;
+
+    uint32_t x = longitude + MAX_LONGITUDE, y = latitude + MAX_LATITUDE;
+    uint64_t key = 0;
+
+    for (uint32_t s = 1u << (HILBERT_BITS - 1); s > 0; s >>= 1) {
+        const uint32_t rx = (x & s) != 0, ry = (y & s) != 0;
+        key += (uint64_t)s * s * ((3 * rx) ^ ry);
+
+        /* rotate the quadrant, so the curve continues there */
+        if (ry == 0) {
+            if (rx == 1) {
+                x = s - 1 - x;
+                y = s - 1 - y;
+            }
+
+            std::swap(x, y);
+        }
+    }
+
+    return key;
+}
+
+TurnPointOrder::TurnPointOrder(const char *args)
+{
+    if (args == NULL || strcmp(args, "hilbert") == 0)
+        order = ORDER_HILBERT;
+    else if (strcmp(args, "name") == 0)
+        order = ORDER_NAME;
+    else
+        throw malformed_input(std::string("Unknown order: ") + args);
+}
+
+uint64_t
+TurnPointOrder::key(const TurnPoint &tp) const
+{
+    if (order == ORDER_HILBERT)
+        return hilbert_key(tp.getPosition());
+
+    /* the first characters decide most comparisons, without calling
+       strcasecmp() */
+    const std::string &name = tp.getAnyName();
+    uint64_t key = 0;
+    for (unsigned i = 0; i < 8; ++i)
+        key = (key << 8) |
+            (i < name.length() ? (unsigned char)tolower((unsigned char)name[i]) : 0);
+
+    return key;
+}
+
+bool
+TurnPointOrder::less(const TurnPoint &a, const TurnPoint &b) const
+{
+    if (order == ORDER_HILBERT)
+        return false;
+
+    return strcasecmp(a.getAnyName().c_str(), b.getAnyName().c_str()) < 0;
+}
+
+static bool
+read_varint(FILE *file, uint64_t &value)
+{
+    value = 0;
+
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        int ch = getc(file);
+        if (ch == EOF)
+            return false;
+
+        value |= (uint64_t)(ch & 0x7f) << shift;
+        if ((ch & 0x80) == 0)
+            return true;
+    }
+
+    throw std::runtime_error("Malformed temporary file");
+}
+
+size_t
+TurnPointRunCodec::getSize(const TurnPoint &tp)
+{
+    return sizeof(tp) + tp.getFullName().capacity() +
+        tp.getShortName().capacity() + tp.getCode().capacity() +
+        tp.getCountry().capacity() + tp.getDescription().capacity();
+}
+
+void
+TurnPointRunCodec::write(FILE *file, const TurnPoint &tp)
+{
+    const std::string *strings[5] = {
+        &tp.getFullName(), &tp.getShortName(), &tp.getCode(),
+        &tp.getCountry(), &tp.getDescription(),
+    };
+    const Position &position = tp.getPosition();
+    const Runway &runway = tp.getRunway();
+    char buffer[VARINT_MAX * 8], *p = buffer;
+
+    p = put_varint(p, zigzag(position.getLatitude().getValue()));
+    p = put_varint(p, zigzag(position.getLongitude().getValue()));
+    p = put_varint(p, zigzag(position.getAltitude().getValue()));
+    p = put_varint(p, position.getAltitude().getUnit() |
+                   (position.getAltitude().getRef() << 2) |
+                   (runway.getType() << 5));
+    p = put_varint(p, tp.getType());
+    p = put_varint(p, runway.getDirection());
+    p = put_varint(p, runway.getLength());
+    p = put_varint(p, tp.getFrequency().getHertz());
+    fwrite(buffer, 1, p - buffer, file);
+
+    for (unsigned i = 0; i < 5; ++i) {
+        p = put_varint(buffer, strings[i]->length());
+        fwrite(buffer, 1, p - buffer, file);
+        fwrite(strings[i]->data(), 1, strings[i]->length(), file);
+    }
+}
+
+bool
+TurnPointRunCodec::read(FILE *file, TurnPoint &tp)
+{
+    uint64_t values[8];
+
+    for (unsigned i = 0; i < 8; ++i) {
+        if (!read_varint(file, values[i])) {
+            if (i > 0 || ferror(file))
+                throw std::runtime_error("Failed to read temporary file");
+            return false;
+        }
+    }
+
+    tp.clear();
+    tp.setPosition(Position(Latitude((int)unzigzag(values[0])),
+                            Longitude((int)unzigzag(values[1])),
+                            Altitude(unzigzag(values[2]),
+                                     (Altitude::unit_t)(values[3] & 0x3),
+                                     (Altitude::ref_t)((values[3] >> 2) & 0x7))));
+    tp.setType((TurnPoint::type_t)values[4]);
+    tp.setRunway(Runway((Runway::type_t)(values[3] >> 5),
+                        values[5], values[6]));
+    tp.setFrequency(Frequency(values[7]));
+
+    std::string buffer;
+    for (unsigned i = 0; i < 5; ++i) {
+        uint64_t length;
+        if (!read_varint(file, length))
+            throw std::runtime_error("Failed to read temporary file");
+
+        buffer.resize(length);
+        if (length > 0 && fread(&buffer[0], 1, length, file) != length)
+            throw std::runtime_error("Failed to read temporary file");
+
+        switch (i) {
+        case 0:
+            tp.setFullName(buffer);
+            break;
+        case 1:
+            tp.setShortName(buffer);
+            break;
+        case 2:
+            tp.setCode(buffer);
+            break;
+        case 3:
+            tp.setCountry(buffer);
+            break;
+        case 4:
+            tp.setDescription(buffer);
+            break;
+        }
+    }
+
+    return true;
+}
+
+TurnPointReader *
+OrderTurnPointFilter::createFilter(TurnPointReader *reader,
+                                   const char *args) const
+{
+    return new OrderTurnPointReader(reader, args);
+}
+
+unsigned
+OrderTurnPointFilter::getFields() const
+{
+    return TurnPoint::FIELD_NAMES | TurnPoint::FIELD_POSITION;
+}
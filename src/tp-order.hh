@@ -0,0 +1,102 @@
+/*
+ * loggertools
+ * Copyright (C) 2004-2008 Max Kellermann <max@duempel.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; version 2 of the License
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef __LOGGERTOOLS_TP_ORDER_HH
+#define __LOGGERTOOLS_TP_ORDER_HH
+
+#include "tp.hh"
+#include "tp-io.hh"
+#include "io-sort.hh"
+
+#include <stdio.h>
+#include <stdint.h>
+
+/**
+ * The position of a point on a Hilbert curve over the lat/lon grid
+ * (in Angle units).  Points which are near each other usually have
+ * near keys.  Undefined positions get the highest key.
+ */
+uint64_t hilbert_key(const SurfacePosition &position);
+
+/**
+ * The order of an "order" filter, for ExternalSorter.
+ */
+class TurnPointOrder {
+public:
+    enum order_t {
+        ORDER_HILBERT,
+        ORDER_NAME
+    };
+
+private:
+    order_t order;
+
+public:
+    /**
+     * @param args "hilbert" or "name"
+     */
+    TurnPointOrder(const char *args);
+
+public:
+    /**
+     * The Hilbert key, or the first 8 characters of the name in
+     * lower case.
+     */
+    uint64_t key(const TurnPoint &tp) const;
+
+    bool less(const TurnPoint &a, const TurnPoint &b) const;
+};
+
+/**
+ * Writes turn points to the temporary files of ExternalSorter: the
+ * numbers as variable length integers, the strings with their
+ * length.
+ */
+struct TurnPointRunCodec {
+    static size_t getSize(const TurnPoint &tp);
+    static void write(FILE *file, const TurnPoint &tp);
+    static bool read(FILE *file, TurnPoint &tp);
+};
+
+/**
+ * A reader which returns the turn points of another reader sorted
+ * by their position on a Hilbert curve, or by name (ignoring case).
+ * Turn points with the same key keep their order.  Inputs which
+ * don't fit into the memory limit are sorted on disk.
+ */
+class OrderTurnPointReader
+    : public SortReader<TurnPoint, TurnPointOrder, TurnPointRunCodec> {
+public:
+    /** the default memory limit */
+    static const size_t DEFAULT_MEMORY = 64 * 1024 * 1024;
+
+    /**
+     * @param reader the input, which is deleted by this object
+     * @param args "hilbert" or "name"
+     * @param memory_limit the estimated number of bytes which may be
+     * used for sorting in memory
+     */
+    OrderTurnPointReader(TurnPointReader *reader, const char *args,
+                         size_t memory_limit = DEFAULT_MEMORY)
+        :SortReader<TurnPoint, TurnPointOrder,
+                    TurnPointRunCodec>(reader, TurnPointOrder(args),
+                                       memory_limit) {}
+};
+
+#endif
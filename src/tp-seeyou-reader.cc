@@ -20,30 +20,171 @@
 #include "exception.hh"
 #include "tp.hh"
 #include "tp-io.hh"
+#include "tp-constraint.hh"
+#include "mapped-file.hh"
+#include "thread.hh"
 
+#include <algorithm>
 #include <istream>
+#include <string>
+#include <vector>
 
 #include <stdlib.h>
 #include <string.h>
 
-class SeeYouTurnPointReader : public TurnPointReader {
+/**
+ * One column of a CUP line.  It points into the line buffer (or into
+ * the mapped file), and it is not null-terminated.
+ */
+struct SeeYouColumn {
+    const char *value;
+    size_t length;
+};
+
+/**
+ * The meaning of a column, as determined from the header line.
+ */
+enum SeeYouField {
+    FIELD_IGNORE,
+    FIELD_NAME,
+    FIELD_CODE,
+    FIELD_COUNTRY,
+    FIELD_LATITUDE,
+    FIELD_LONGITUDE,
+    FIELD_ELEVATION,
+    FIELD_STYLE,
+    FIELD_DIRECTION,
+    FIELD_LENGTH,
+    FIELD_FREQUENCY,
+    FIELD_DESCRIPTION
+};
+
+static const struct {
+    const char *name;
+    SeeYouField field;
+} seeyou_field_names[] = {
+    { "title", FIELD_NAME },
+    { "name", FIELD_NAME },
+    { "code", FIELD_CODE },
+    { "country", FIELD_COUNTRY },
+    { "latitude", FIELD_LATITUDE },
+    { "lat", FIELD_LATITUDE },
+    { "longitude", FIELD_LONGITUDE },
+    { "lon", FIELD_LONGITUDE },
+    { "elevation", FIELD_ELEVATION },
+    { "elev", FIELD_ELEVATION },
+    { "style", FIELD_STYLE },
+    { "direction", FIELD_DIRECTION },
+    { "rwdir", FIELD_DIRECTION },
+    { "length", FIELD_LENGTH },
+    { "rwlen", FIELD_LENGTH },
+    { "frequency", FIELD_FREQUENCY },
+    { "freq", FIELD_FREQUENCY },
+    { "description", FIELD_DESCRIPTION },
+    { "desc", FIELD_DESCRIPTION },
+};
+
+/**
+ * The mapped file is split into chunks of about this size, which are
+ * parsed by worker threads.
+ */
+static const size_t CHUNK_SIZE = 256 * 1024;
+
+/**
+ * A range of complete lines within the mapped file.
+ */
+struct SeeYouChunk {
+    const char *begin, *end;
+};
+
+/**
+ * The turn points parsed from one chunk.  There is a fixed number of
+ * slots, which are reused round-robin; chunk n goes to slot n %
+ * slots.size().
+ */
+struct SeeYouSlot {
+    std::vector<TurnPoint> points;
+    size_t count;
+    bool done;
+
+    SeeYouSlot():count(0), done(false) {}
+};
+
+/**
+ * Buffers for parsing one line.  Each thread has its own.
+ */
+struct SeeYouLineBuffer {
+    /** the columns of the current line */
+    std::vector<SeeYouColumn> row;
+    /** for copying string columns into the TurnPoint */
+    std::string value;
+};
+
+class SeeYouWorker;
+
+class SeeYouTurnPointReader : public TurnPointRecordReader {
+    friend class SeeYouWorker;
+
 private:
+    /** the input stream; NULL if the file is mapped into memory */
     std::istream *stream;
+    /** the mapped file; NULL if reading from a stream */
+    MappedFile *file;
+    /** the read position within the mapped file */
+    const char *position;
+    /** the current line, only used when reading from a stream */
+    std::string line;
+    SeeYouLineBuffer buffer;
     bool is_eof;
-    unsigned num_columns;
-    char **columns;
+    /** the field of each column; trailing columns which are ignored
+        are not in this list, so they are not even parsed */
+    std::vector<SeeYouField> columns;
+    /** the index of the columns which are needed for checking the
+        constraint of the predicate; -1 if there is none */
+    int latitude_column, longitude_column, style_column;
+    /** only turn points matching this are returned */
+    ReaderPredicate predicate;
+
+    /* the following attributes are used only when the mapped file
+       is parsed by worker threads; "chunks" is empty otherwise */
+    std::vector<SeeYouChunk> chunks;
+    std::vector<SeeYouSlot> slots;
+    std::vector<SeeYouWorker*> workers;
+    Mutex mutex;
+    Cond cond;
+    /** the next chunk to be parsed by a worker */
+    size_t next_chunk;
+    /** the chunk which is currently being returned by read_into() */
+    size_t current_chunk;
+    size_t current_point;
+    bool started, quit, failed;
+
 public:
     SeeYouTurnPointReader(std::istream *stream);
+    SeeYouTurnPointReader(MappedFile *file);
     virtual ~SeeYouTurnPointReader();
+private:
+    bool read_line(const char *&begin, const char *&end);
+    void read_header();
+    void update_columns();
+    bool check_constraint(const std::vector<SeeYouColumn> &row) const;
+    bool parse_line(const char *p, const char *end,
+                    TurnPoint &tp, SeeYouLineBuffer &buffer) const;
+    void start_workers();
+    void stop_workers();
+    void work();
+    bool read_parsed(TurnPoint &tp);
 public:
-    virtual const TurnPoint *read();
+    virtual bool setPredicate(Predicate<TurnPoint> *_predicate);
+    virtual void setFields(unsigned fields);
+    virtual bool read_into(TurnPoint &tp);
 };
 
-static unsigned count_columns(const char *p) {
+static unsigned count_columns(const char *p, const char *end) {
     unsigned count = 1;
     int in_string = 0;
 
-    for (; *p; p++) {
+    for (; p < end; p++) {
         if (*p == '"')
             in_string = !in_string;
         else if (!in_string && *p == ',')
@@ -53,92 +194,244 @@ static unsigned count_columns(const char *p) {
     return count;
 }
 
-static int read_column(const char **line, char *column, size_t column_max_len) {
-    if (**line == 0)
-        return 0;
+static bool
+read_column(const char *&p, const char *end, SeeYouColumn &column)
+{
+    column.value = p;
+    column.length = 0;
 
-    if (**line == '"') {
-        (*line)++;
+    if (p >= end)
+        return false;
 
-        for (; **line != 0 && **line != '"'; (*line)++) {
-            if (column_max_len > 1) {
-                *column++ = **line;
-                column_max_len--;
-            }
-        }
+    if (*p == '"') {
+        column.value = ++p;
 
-        *column = 0;
+        while (p < end && *p != '"')
+            p++;
 
-        if (**line == '"') {
-            (*line)++;
+        column.length = p - column.value;
 
-            while (**line > 0 && **line <= ' ')
-                (*line)++;
+        if (p < end) {
+            p++;
+
+            while (p < end && *p > 0 && *p <= ' ')
+                p++;
         }
     } else {
-        char *first_whitespace = NULL;
-
-        for (; **line != 0 && **line != ','; (*line)++) {
-            if (**line > 0 && **line <= ' ') {
-                if (first_whitespace == NULL)
-                    first_whitespace = column;
-            } else {
-                first_whitespace = NULL;
-            }
+        /* trailing whitespace is not part of the value */
+        const char *value_end = p;
 
-            if (column_max_len > 1) {
-                *column++ = **line;
-                column_max_len--;
-            }
+        for (; p < end && *p != ','; p++)
+            if (*p <= 0 || *p > ' ')
+                value_end = p + 1;
+
+        column.length = value_end - column.value;
+    }
+
+    if (p < end && *p == ',')
+        p++;
+
+    return true;
+}
+
+/**
+ * Copy a column into a null-terminated buffer, for the numeric
+ * parsers.  Numeric columns are short; longer ones are truncated.
+ */
+static const char *
+column_cstr(const SeeYouColumn &column, char *buffer, size_t size)
+{
+    size_t length = column.length < size ? column.length : size - 1;
+
+    memcpy(buffer, column.value, length);
+    buffer[length] = 0;
+    return buffer;
+}
+
+/**
+ * Copy a column into a std::string.  The caller passes the same
+ * buffer for all rows, which saves a memory allocation per column.
+ */
+static const std::string &
+column_string(const SeeYouColumn &column, std::string &buffer)
+{
+    buffer.assign(column.value, column.length);
+    return buffer;
+}
+
+class SeeYouWorker : public Thread {
+private:
+    SeeYouTurnPointReader &reader;
+
+public:
+    SeeYouWorker(SeeYouTurnPointReader &_reader)
+        :reader(_reader) {}
+
+protected:
+    virtual void run() {
+        reader.work();
+    }
+};
+
+SeeYouTurnPointReader::SeeYouTurnPointReader(std::istream *_stream)
+    :stream(_stream), file(NULL), position(NULL), is_eof(false),
+     latitude_column(-1), longitude_column(-1), style_column(-1),
+     next_chunk(0), current_chunk(0), current_point(0),
+     started(false), quit(false), failed(false) {
+    read_header();
+}
+
+SeeYouTurnPointReader::SeeYouTurnPointReader(MappedFile *_file)
+    :stream(NULL), file(_file), position(_file->begin()), is_eof(false),
+     latitude_column(-1), longitude_column(-1), style_column(-1),
+     next_chunk(0), current_chunk(0), current_point(0),
+     started(false), quit(false), failed(false) {
+    read_header();
+}
+
+SeeYouTurnPointReader::~SeeYouTurnPointReader() {
+    stop_workers();
+
+    if (file != NULL)
+        delete file;
+}
+
+bool
+SeeYouTurnPointReader::read_line(const char *&begin, const char *&end)
+{
+    if (file != NULL) {
+        const char *file_end = file->end(), *newline;
+
+        if (position >= file_end)
+            return false;
+
+        newline = (const char*)memchr(position, '\n', file_end - position);
+        begin = position;
+        if (newline == NULL) {
+            end = position = file_end;
+        } else {
+            end = newline;
+            position = newline + 1;
         }
 
-        if (first_whitespace == NULL)
-            *column = 0;
+        return true;
+    }
+
+    if (stream->eof())
+        return false;
+
+    try {
+        if (!std::getline(*stream, line))
+            return false;
+    } catch (const std::ios_base::failure &e) {
+        if (stream->eof())
+            return false;
         else
-            *first_whitespace = 0;
+            throw;
     }
 
-    if (**line == ',')
-        (*line)++;
+    begin = line.data();
+    end = begin + line.length();
+    return true;
+}
 
-    return 1;
+static SeeYouField
+parse_field_name(const SeeYouColumn &column)
+{
+    for (unsigned i = 0;
+         i < sizeof(seeyou_field_names) / sizeof(seeyou_field_names[0]);
+         ++i)
+        if (strlen(seeyou_field_names[i].name) == column.length &&
+            strncasecmp(seeyou_field_names[i].name, column.value,
+                        column.length) == 0)
+            return seeyou_field_names[i].field;
+
+    return FIELD_IGNORE;
 }
 
-SeeYouTurnPointReader::SeeYouTurnPointReader(std::istream *_stream)
-    :stream(_stream), is_eof(false),
-     num_columns(0), columns(NULL) {
-    char line[4096], column[1024];
-    const char *p;
-    unsigned z;
-    int ret;
+/**
+ * Which TurnPoint fields are set from a column?
+ */
+static unsigned
+field_mask(SeeYouField field)
+{
+    switch (field) {
+    case FIELD_IGNORE:
+        return 0;
+    case FIELD_NAME:
+        return TurnPoint::FIELD_FULL_NAME;
+    case FIELD_CODE:
+        return TurnPoint::FIELD_CODE;
+    case FIELD_COUNTRY:
+        return TurnPoint::FIELD_COUNTRY;
+    case FIELD_LATITUDE:
+    case FIELD_LONGITUDE:
+    case FIELD_ELEVATION:
+        return TurnPoint::FIELD_POSITION;
+    case FIELD_STYLE:
+        /* the style also determines the runway type */
+        return TurnPoint::FIELD_TYPE | TurnPoint::FIELD_RUNWAY;
+    case FIELD_DIRECTION:
+    case FIELD_LENGTH:
+        return TurnPoint::FIELD_RUNWAY;
+    case FIELD_FREQUENCY:
+        return TurnPoint::FIELD_FREQUENCY;
+    case FIELD_DESCRIPTION:
+        return TurnPoint::FIELD_DESCRIPTION;
+    }
 
-    stream->getline(line, sizeof(line));
+    return 0;
+}
+
+void
+SeeYouTurnPointReader::read_header()
+{
+    const char *p, *end;
+    SeeYouColumn column;
+    unsigned num_columns, z;
+
+    if (!read_line(p, end))
+        throw malformed_input("no header");
 
-    num_columns = count_columns(line);
+    num_columns = count_columns(p, end);
     if (num_columns == 0)
         throw malformed_input("no columns in header");
 
-    columns = (char**)malloc(num_columns * sizeof(*columns));
-    if (columns == NULL)
-        throw std::bad_alloc();
+    columns.reserve(num_columns);
 
-    for (p = line, z = 0; z < num_columns; z++) {
-        ret = read_column(&p, column, sizeof(column));
-        if (!ret)
-            column[0] = 0;
+    for (z = 0; z < num_columns; z++) {
+        read_column(p, end, column);
 
-        if (column[0] == 0)
-            columns[z] = NULL;
-        else
-            columns[z] = strdup(column);
+        columns.push_back(parse_field_name(column));
     }
+
+    update_columns();
 }
 
-SeeYouTurnPointReader::~SeeYouTurnPointReader() {
-    for (unsigned i = 0; i < num_columns; ++i)
-        if (columns[i] != NULL)
-            free(columns[i]);
-    free(columns);
+/**
+ * Remove trailing ignored columns from the list, so they are not
+ * even split, and look up the columns needed by check_constraint().
+ */
+void
+SeeYouTurnPointReader::update_columns()
+{
+    unsigned z, num_used = 0;
+
+    latitude_column = longitude_column = style_column = -1;
+
+    for (z = 0; z < columns.size(); ++z) {
+        if (columns[z] != FIELD_IGNORE)
+            num_used = z + 1;
+
+        if (columns[z] == FIELD_LATITUDE)
+            latitude_column = z;
+        else if (columns[z] == FIELD_LONGITUDE)
+            longitude_column = z;
+        else if (columns[z] == FIELD_STYLE)
+            style_column = z;
+    }
+
+    columns.resize(num_used);
 }
 
 template<class T, char minusLetter, char plusLetter>
@@ -193,12 +486,127 @@ static const Frequency parseFrequency(const char *p) {
     return Frequency(n1, n2);
 }
 
-const TurnPoint *SeeYouTurnPointReader::read() {
-    char line[4096], column[1024];
-    const char *p = line;
+static TurnPoint::type_t
+parseStyle(const char *p, Runway::type_t &rwy_type)
+{
+    switch (atoi(p)) {
+    case 2:
+        rwy_type = Runway::TYPE_GRASS;
+        return TurnPoint::TYPE_AIRFIELD;
+    case 3:
+        return TurnPoint::TYPE_OUTLANDING;
+    case 4:
+        return TurnPoint::TYPE_GLIDER_SITE;
+    case 5:
+        rwy_type = Runway::TYPE_ASPHALT;
+        return TurnPoint::TYPE_AIRFIELD;
+    case 6:
+        return TurnPoint::TYPE_MOUNTAIN_PASS;
+    case 7:
+        return TurnPoint::TYPE_MOUNTAIN_TOP;
+    case 8:
+        return TurnPoint::TYPE_SENDER;
+    case 9:
+        return TurnPoint::TYPE_VOR;
+    case 10:
+        return TurnPoint::TYPE_NDB;
+    case 11:
+        return TurnPoint::TYPE_COOL_TOWER;
+    case 12:
+        return TurnPoint::TYPE_DAM;
+    case 13:
+        return TurnPoint::TYPE_TUNNEL;
+    case 14:
+        return TurnPoint::TYPE_BRIDGE;
+    case 15:
+        return TurnPoint::TYPE_POWER_PLANT;
+    case 16:
+        return TurnPoint::TYPE_CASTLE;
+    case 17:
+        return TurnPoint::TYPE_HIGHWAY_INTERSECTION;
+    default:
+        return TurnPoint::TYPE_UNKNOWN;
+    }
+}
+
+/**
+ * Find the beginning of the "-----Related Tasks" section, which ends
+ * the list of turn points.  Returns "end" if there is none.
+ */
+static const char *
+find_related(const char *p, const char *end)
+{
+    const char *start = p;
+
+    while (end - p >= 12) {
+        p = (const char*)memmem(p, end - p, "-----Related", 12);
+        if (p == NULL)
+            break;
+
+        if (p == start || p[-1] == '\n')
+            return p;
+
+        ++p;
+    }
+
+    return end;
+}
+
+/**
+ * Check the type and the position of a line against the constraint
+ * of the predicate, before the TurnPoint is built.
+ */
+bool
+SeeYouTurnPointReader::check_constraint(const std::vector<SeeYouColumn> &row) const
+{
+    const TurnPointConstraint &constraint = predicate.getConstraint();
+    char number[32];
+
+    if (constraint.hasTypes()) {
+        TurnPoint::type_t type = TurnPoint::TYPE_UNKNOWN;
+        Runway::type_t rwy_type;
+
+        if (style_column >= 0)
+            type = parseStyle(column_cstr(row[style_column], number,
+                                          sizeof(number)),
+                              rwy_type);
+
+        if (!constraint.matchType(type))
+            return false;
+    }
+
+    if (constraint.hasPositions()) {
+        Latitude latitude;
+        Longitude longitude;
+
+        if (latitude_column >= 0)
+            latitude = parseAngle<Latitude,'S','N'>
+                (column_cstr(row[latitude_column], number, sizeof(number)));
+        if (longitude_column >= 0)
+            longitude = parseAngle<Longitude,'W','E'>
+                (column_cstr(row[longitude_column], number, sizeof(number)));
+
+        if (!constraint.matchPosition(latitude.defined() &&
+                                      longitude.defined()
+                                      ? SurfacePosition(latitude, longitude)
+                                      : SurfacePosition()))
+            return false;
+    }
+
+    return true;
+}
+
+/**
+ * Parse a line into the TurnPoint.  Returns false if it does not
+ * match the predicate; the TurnPoint is undefined then.
+ */
+bool
+SeeYouTurnPointReader::parse_line(const char *p, const char *end,
+                                  TurnPoint &tp,
+                                  SeeYouLineBuffer &buffer) const
+{
+    char number[32];
     unsigned z;
-    int ret;
-    TurnPoint tp;
     Latitude latitude;
     Longitude longitude;
     Altitude altitude;
@@ -206,130 +614,87 @@ const TurnPoint *SeeYouTurnPointReader::read() {
     unsigned rwy_direction = Runway::DIRECTION_UNDEFINED;
     unsigned rwy_length = Runway::LENGTH_UNDEFINED;
 
-    if (is_eof || stream->eof())
-        return NULL;
+    buffer.row.resize(columns.size());
+    for (z = 0; z < columns.size(); z++)
+        read_column(p, end, buffer.row[z]);
 
-    try {
-        stream->getline(line, sizeof(line));
-    } catch (const std::ios_base::failure &e) {
-        if (stream->eof())
-            return NULL;
-        else
-            throw;
-    }
+    /* rejected lines are skipped before any string is copied */
+    if (predicate.defined() && !check_constraint(buffer.row))
+        return false;
 
-    if (strncmp(p, "-----Related", 12) == 0) {
-        is_eof = true;
-        return NULL;
-    }
+    tp.clear();
 
-    for (z = 0; z < num_columns; z++) {
-        ret = read_column(&p, column, sizeof(column));
-        if (!ret)
-            column[0] = 0;
-
-        if (columns[z] == NULL)
-            continue;
-
-        if (strcasecmp(columns[z], "title") == 0 ||
-            strcasecmp(columns[z], "name") == 0) {
-            tp.setFullName(column);
-        } else if (strcasecmp(columns[z], "code") == 0) {
-            tp.setCode(column);
-        } else if (strcasecmp(columns[z], "country") == 0) {
-            tp.setCountry(column);
-        } else if (strcasecmp(columns[z], "latitude") == 0 ||
-                   strcasecmp(columns[z], "lat") == 0) {
-            latitude = parseAngle<Latitude,'S','N'>(column);
-        } else if (strcasecmp(columns[z], "longitude") == 0 ||
-                   strcasecmp(columns[z], "lon") == 0) {
-            longitude = parseAngle<Longitude,'W','E'>(column);
-        } else if (strcasecmp(columns[z], "elevation") == 0 ||
-                   strcasecmp(columns[z], "elev") == 0) {
-            if (*column == 0)
+    for (z = 0; z < columns.size(); z++) {
+        const SeeYouColumn &column = buffer.row[z];
+
+        switch (columns[z]) {
+        case FIELD_IGNORE:
+            break;
+
+        case FIELD_NAME:
+            tp.setFullName(column_string(column, buffer.value));
+            break;
+
+        case FIELD_CODE:
+            tp.setCode(column_string(column, buffer.value));
+            break;
+
+        case FIELD_COUNTRY:
+            tp.setCountry(column_string(column, buffer.value));
+            break;
+
+        case FIELD_LATITUDE:
+            column_cstr(column, number, sizeof(number));
+            latitude = parseAngle<Latitude,'S','N'>(number);
+            break;
+
+        case FIELD_LONGITUDE:
+            column_cstr(column, number, sizeof(number));
+            longitude = parseAngle<Longitude,'W','E'>(number);
+            break;
+
+        case FIELD_ELEVATION:
+            if (column.length == 0)
                 altitude = Altitude();
             else
-                altitude = Altitude(strtol(column, NULL, 10),
+                altitude = Altitude(strtol(column_cstr(column, number,
+                                                       sizeof(number)),
+                                           NULL, 10),
                                     Altitude::UNIT_METERS,
                                     Altitude::REF_MSL);
-        } else if (strcasecmp(columns[z], "style") == 0) {
-            TurnPoint::type_t type;
-
-            switch (atoi(column)) {
-            case 2:
-                rwy_type = Runway::TYPE_GRASS;
-                type = TurnPoint::TYPE_AIRFIELD;
-                break;
-            case 3:
-                type = TurnPoint::TYPE_OUTLANDING;
-                break;
-            case 4:
-                type = TurnPoint::TYPE_GLIDER_SITE;
-                break;
-            case 5:
-                rwy_type = Runway::TYPE_ASPHALT;
-                type = TurnPoint::TYPE_AIRFIELD;
-                break;
-            case 6:
-                type = TurnPoint::TYPE_MOUNTAIN_PASS;
-                break;
-            case 7:
-                type = TurnPoint::TYPE_MOUNTAIN_TOP;
-                break;
-            case 8:
-                type = TurnPoint::TYPE_SENDER;
-                break;
-            case 9:
-                type = TurnPoint::TYPE_VOR;
-                break;
-            case 10:
-                type = TurnPoint::TYPE_NDB;
-                break;
-            case 11:
-                type = TurnPoint::TYPE_COOL_TOWER;
-                break;
-            case 12:
-                type = TurnPoint::TYPE_DAM;
-                break;
-            case 13:
-                type = TurnPoint::TYPE_TUNNEL;
-                break;
-            case 14:
-                type = TurnPoint::TYPE_BRIDGE;
-                break;
-            case 15:
-                type = TurnPoint::TYPE_POWER_PLANT;
-                break;
-            case 16:
-                type = TurnPoint::TYPE_CASTLE;
-                break;
-            case 17:
-                type = TurnPoint::TYPE_HIGHWAY_INTERSECTION;
-                break;
-            default:
-                type = TurnPoint::TYPE_UNKNOWN;
-            }
-            tp.setType(type);
-        } else if (strcasecmp(columns[z], "direction") == 0 ||
-                   strcasecmp(columns[z], "rwdir") == 0) {
-            if (*column != 0) {
-                rwy_direction = (unsigned)atoi(column);
+            break;
+
+        case FIELD_STYLE:
+            tp.setType(parseStyle(column_cstr(column, number, sizeof(number)),
+                                  rwy_type));
+            break;
+
+        case FIELD_DIRECTION:
+            if (column.length > 0) {
+                column_cstr(column, number, sizeof(number));
+                rwy_direction = (unsigned)atoi(number);
                 if (rwy_direction < 10 || rwy_direction > 360 ||
                     rwy_direction % 10 != 0)
                     rwy_direction = Runway::DIRECTION_UNDEFINED;
                 else
                     rwy_direction /= 10;
             }
-        } else if (strcasecmp(columns[z], "length") == 0 ||
-                   strcasecmp(columns[z], "rwlen") == 0) {
-            if (*column != 0)
-                rwy_length = (unsigned)atoi(column);
-        } else if (strcasecmp(columns[z], "frequency") == 0 ||
-                   strcasecmp(columns[z], "freq") == 0) {
-            tp.setFrequency(parseFrequency(column));
-        } else if (strcasecmp(columns[z], "description") == 0 ||
-                   strcasecmp(columns[z], "desc") == 0) {
-            tp.setDescription(column);
+            break;
+
+        case FIELD_LENGTH:
+            if (column.length > 0)
+                rwy_length = (unsigned)atoi(column_cstr(column, number,
+                                                        sizeof(number)));
+            break;
+
+        case FIELD_FREQUENCY:
+            column_cstr(column, number, sizeof(number));
+            tp.setFrequency(parseFrequency(number));
+            break;
+
+        case FIELD_DESCRIPTION:
+            tp.setDescription(column_string(column, buffer.value));
+            break;
         }
     }
 
@@ -340,10 +705,233 @@ const TurnPoint *SeeYouTurnPointReader::read() {
 
     tp.setRunway(Runway(rwy_type, rwy_direction, rwy_length));
 
-    return new TurnPoint(tp);
+    return predicate.match(tp);
+}
+
+void
+SeeYouTurnPointReader::start_workers()
+{
+    const char *p = position, *end = find_related(position, file->end());
+    unsigned num_workers = Thread::countProcessors();
+
+    if (num_workers < 2 || (size_t)(end - p) < 2 * CHUNK_SIZE)
+        return;
+
+    /* split the file after a newline; a record never spans more than
+       one line, so this is always a record boundary */
+    while (p < end) {
+        SeeYouChunk chunk;
+        const char *newline;
+
+        chunk.begin = p;
+        if ((size_t)(end - p) <= CHUNK_SIZE ||
+            (newline = (const char*)memchr(p + CHUNK_SIZE, '\n',
+                                            end - p - CHUNK_SIZE)) == NULL)
+            chunk.end = end;
+        else
+            chunk.end = newline + 1;
+
+        chunks.push_back(chunk);
+        p = chunk.end;
+    }
+
+    if (num_workers > chunks.size())
+        num_workers = chunks.size();
+
+    slots.resize(num_workers * 2);
+
+    for (unsigned i = 0; i < num_workers; ++i) {
+        SeeYouWorker *worker = new SeeYouWorker(*this);
+        if (!worker->start()) {
+            delete worker;
+            break;
+        }
+
+        workers.push_back(worker);
+    }
+
+    if (workers.empty())
+        /* fall back to parsing in this thread */
+        chunks.clear();
+}
+
+void
+SeeYouTurnPointReader::stop_workers()
+{
+    mutex.lock();
+    quit = true;
+    cond.broadcast();
+    mutex.unlock();
+
+    for (std::vector<SeeYouWorker*>::iterator it = workers.begin();
+         it != workers.end(); ++it) {
+        (*it)->join();
+        delete *it;
+    }
+
+    workers.clear();
+}
+
+void
+SeeYouTurnPointReader::work()
+{
+    SeeYouLineBuffer line_buffer;
+
+    mutex.lock();
+
+    while (true) {
+        while (!quit && next_chunk < chunks.size() &&
+               next_chunk >= current_chunk + slots.size())
+            cond.wait(mutex);
+
+        if (quit || next_chunk >= chunks.size())
+            break;
+
+        const SeeYouChunk &chunk = chunks[next_chunk];
+        SeeYouSlot &slot = slots[next_chunk % slots.size()];
+        ++next_chunk;
+
+        mutex.unlock();
+
+        bool success = true;
+        const char *p = chunk.begin;
+        slot.count = 0;
+
+        try {
+            while (p < chunk.end) {
+                const char *newline = (const char*)
+                    memchr(p, '\n', chunk.end - p);
+                const char *line_end = newline != NULL ? newline : chunk.end;
+
+                if (slot.count == slot.points.size())
+                    slot.points.push_back(TurnPoint());
+
+                if (parse_line(p, line_end, slot.points[slot.count],
+                               line_buffer))
+                    ++slot.count;
+
+                p = newline != NULL ? newline + 1 : chunk.end;
+            }
+        } catch (const std::bad_alloc &) {
+            success = false;
+        }
+
+        mutex.lock();
+
+        if (!success)
+            failed = true;
+        slot.done = true;
+        cond.broadcast();
+    }
+
+    mutex.unlock();
+}
+
+/**
+ * Return the next turn point parsed by the worker threads.
+ */
+bool
+SeeYouTurnPointReader::read_parsed(TurnPoint &tp)
+{
+    while (current_chunk < chunks.size()) {
+        SeeYouSlot &slot = slots[current_chunk % slots.size()];
+
+        if (current_point == 0) {
+            /* wait for the worker; after that, this slot belongs to
+               us until we move to the next chunk */
+            ScopeLock lock(mutex);
+
+            while (!slot.done)
+                cond.wait(mutex);
+
+            if (failed)
+                throw std::bad_alloc();
+        }
+
+        if (current_point < slot.count) {
+            std::swap(tp, slot.points[current_point++]);
+            return true;
+        }
+
+        ScopeLock lock(mutex);
+        slot.done = false;
+        ++current_chunk;
+        current_point = 0;
+        cond.broadcast();
+    }
+
+    return false;
+}
+
+void
+SeeYouTurnPointReader::setFields(unsigned fields)
+{
+    if (started)
+        return;
+
+    /* the columns which are not needed are ignored */
+    for (std::vector<SeeYouField>::iterator it = columns.begin();
+         it != columns.end(); ++it)
+        if ((field_mask(*it) & fields) == 0)
+            *it = FIELD_IGNORE;
+
+    update_columns();
+}
+
+bool
+SeeYouTurnPointReader::setPredicate(Predicate<TurnPoint> *_predicate)
+{
+    if (started)
+        return false;
+
+    return predicate.set(_predicate);
+}
+
+bool SeeYouTurnPointReader::read_into(TurnPoint &tp) {
+    if (!started) {
+        /* the workers are started with the first read, after the
+           predicate has been set */
+        started = true;
+        if (file != NULL)
+            start_workers();
+    }
+
+    if (!chunks.empty())
+        return read_parsed(tp);
+
+    while (!is_eof) {
+        const char *p, *end;
+
+        if (!read_line(p, end))
+            return false;
+
+        if (end - p >= 12 && memcmp(p, "-----Related", 12) == 0) {
+            is_eof = true;
+            return false;
+        }
+
+        if (parse_line(p, end, tp, buffer))
+            return true;
+    }
+
+    return false;
 }
 
 TurnPointReader *
 SeeYouTurnPointFormat::createReader(std::istream *stream) const {
     return new SeeYouTurnPointReader(stream);
 }
+
+TurnPointReader *
+SeeYouTurnPointFormat::createFileReader(const char *path) const {
+    if (!MappedFile::isMappable(path))
+        return NULL;
+
+    MappedFile *file = new MappedFile(path);
+    try {
+        return new SeeYouTurnPointReader(file);
+    } catch (...) {
+        delete file;
+        throw;
+    }
+}
@@ -0,0 +1,81 @@
+/*
+ * loggertools
+ * Copyright (C) 2004-2008 Max Kellermann <max@duempel.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; version 2 of the License
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include "tp-table.hh"
+
+#include <strings.h>
+
+/** the number of turn points loaded with one read_batch() call */
+static const size_t LOAD_BATCH = 256;
+
+size_t
+TurnPointTable::add(const TurnPoint &tp)
+{
+    Record record;
+
+    record.full_name = strings.intern(tp.getFullName());
+    record.short_name = strings.intern(tp.getShortName());
+    record.code = strings.intern(tp.getCode());
+    record.country = strings.intern(tp.getCountry());
+    record.description = strings.intern(tp.getDescription());
+    record.position = tp.getPosition();
+    record.type = tp.getType();
+    record.runway = tp.getRunway();
+    record.frequency = tp.getFrequency();
+
+    records.push_back(record);
+    return records.size() - 1;
+}
+
+void
+TurnPointTable::load(TurnPointReader &reader)
+{
+    std::vector<TurnPoint> buffer(LOAD_BATCH);
+    size_t count;
+
+    while ((count = reader.read_batch(&buffer[0], buffer.size())) > 0)
+        for (size_t i = 0; i < count; ++i)
+            add(buffer[i]);
+}
+
+bool
+TurnPointTable::hasName(size_t i, const std::string &name) const
+{
+    const Record &record = records[i];
+
+    return strcasecmp(strings.get(record.code), name.c_str()) == 0 ||
+        strcasecmp(strings.get(record.short_name), name.c_str()) == 0 ||
+        strcasecmp(strings.get(record.full_name), name.c_str()) == 0;
+}
+
+void
+TurnPointTable::get(size_t i, TurnPoint &dest) const
+{
+    const Record &record = records[i];
+
+    dest.setFullName(strings.get(record.full_name));
+    dest.setShortName(strings.get(record.short_name));
+    dest.setCode(strings.get(record.code));
+    dest.setCountry(strings.get(record.country));
+    dest.setDescription(strings.get(record.description));
+    dest.setPosition(record.position);
+    dest.setType(record.type);
+    dest.setRunway(record.runway);
+    dest.setFrequency(record.frequency);
+}
@@ -0,0 +1,93 @@
+/*
+ * loggertools
+ * Copyright (C) 2004-2008 Max Kellermann <max@duempel.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; version 2 of the License
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef __LOGGERTOOLS_TP_TABLE_HH
+#define __LOGGERTOOLS_TP_TABLE_HH
+
+#include "tp.hh"
+#include "tp-io.hh"
+#include "string-pool.hh"
+
+#include <string>
+#include <vector>
+
+/**
+ * A compact in-memory copy of many turn points.  The strings are
+ * interned in a StringPool, so repeated values (countries,
+ * descriptions) are stored only once, and each record holds small
+ * handles instead of std::string objects.
+ */
+class TurnPointTable {
+public:
+    struct Record {
+        StringPool::handle_t full_name, short_name, code, country,
+            description;
+        Position position;
+        TurnPoint::type_t type;
+        Runway runway;
+        Frequency frequency;
+    };
+
+private:
+    StringPool strings;
+    std::vector<Record> records;
+
+public:
+    size_t size() const {
+        return records.size();
+    }
+
+    /**
+     * Append a copy of the turn point, and return its number.
+     */
+    size_t add(const TurnPoint &tp);
+
+    /**
+     * Load all turn points from the reader (without deleting it).
+     */
+    void load(TurnPointReader &reader);
+
+    Record &operator [](size_t i) {
+        return records[i];
+    }
+
+    const Record &operator [](size_t i) const {
+        return records[i];
+    }
+
+    const char *getString(StringPool::handle_t handle) const {
+        return strings.get(handle);
+    }
+
+    const Position &getPosition(size_t i) const {
+        return records[i].position;
+    }
+
+    /**
+     * Same as TurnPoint::hasName().
+     */
+    bool hasName(size_t i, const std::string &name) const;
+
+    /**
+     * Copy a turn point into a TurnPoint object.
+     */
+    void get(size_t i, TurnPoint &dest) const;
+};
+
+#endif
@@ -25,14 +25,14 @@
 #include <stdlib.h>
 #include <string.h>
 
-class ZanderTurnPointReader : public TurnPointReader {
+class ZanderTurnPointReader : public TurnPointRecordReader {
 private:
     std::istream *stream;
     bool is_eof;
 public:
     ZanderTurnPointReader(std::istream *stream);
 public:
-    virtual const TurnPoint *read();
+    virtual bool read_into(TurnPoint &tp);
 };
 
 ZanderTurnPointReader::ZanderTurnPointReader(std::istream *_stream)
@@ -118,32 +118,33 @@ static const char *get_next_column(char **pp, size_t width) {
     return p;
 }
 
-const TurnPoint *ZanderTurnPointReader::read() {
+bool ZanderTurnPointReader::read_into(TurnPoint &tp) {
     char line[256], *p = line;
     const char *q;
-    TurnPoint tp;
     Latitude latitude;
     Longitude longitude;
     Altitude altitude;
     Runway::type_t rwy_type = Runway::TYPE_UNKNOWN;
 
     if (is_eof || stream->eof())
-        return NULL;
+        return false;
 
     try {
         stream->getline(line, sizeof(line));
     } catch (const std::ios_base::failure &e) {
         if (stream->eof())
-            return NULL;
+            return false;
         else
             throw;
     }
 
     if (line[0] == '\x1a') {
         is_eof = true;
-        return NULL;
+        return false;
     }
 
+    tp.clear();
+
     tp.setFullName(get_next_column(&p, 13));
 
     latitude = parseAngle<Latitude,'S','N'>(get_next_column(&p, 8));
@@ -178,7 +179,7 @@ const TurnPoint *ZanderTurnPointReader::read() {
 
     tp.setCountry(get_next_column(&p, 2));
 
-    return new TurnPoint(tp);
+    return true;
 }
 
 TurnPointReader *
@@ -35,6 +35,7 @@ public:
 public:
     virtual void write(const TurnPoint &tp);
     virtual void flush();
+    virtual unsigned getFields() const;
 };
 
 static void write_column(std::ostream *stream, const std::string &value,
@@ -190,6 +191,12 @@ void ZanderTurnPointWriter::flush() {
     stream = NULL;
 }
 
+unsigned ZanderTurnPointWriter::getFields() const {
+    return TurnPoint::FIELD_NAMES | TurnPoint::FIELD_COUNTRY |
+        TurnPoint::FIELD_POSITION | TurnPoint::FIELD_TYPE |
+        TurnPoint::FIELD_RUNWAY | TurnPoint::FIELD_FREQUENCY;
+}
+
 TurnPointWriter *
 ZanderTurnPointFormat::createWriter(std::ostream *stream) const {
     return new ZanderTurnPointWriter(stream);
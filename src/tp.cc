@@ -20,6 +20,7 @@
 #include "tp.hh"
 
 #include <assert.h>
+#include <string.h>
 
 Runway::Runway()
     :type(TYPE_UNKNOWN), direction(DIRECTION_UNDEFINED),
@@ -55,18 +56,51 @@ TurnPoint::TurnPoint(const std::string &_fullName,
      description(_description) {
 }
 
+void TurnPoint::clear() {
+    fullName.clear();
+    shortName.clear();
+    code.clear();
+    country.clear();
+    position = Position();
+    type = TYPE_UNKNOWN;
+    runway = Runway();
+    frequency = Frequency();
+    description.clear();
+}
+
 void TurnPoint::setFullName(const std::string &_fullName) {
     fullName = _fullName;
 }
 
+void TurnPoint::setFullName(const char *_fullName) {
+    if (_fullName != NULL)
+        fullName.assign(_fullName);
+    else
+        fullName.clear();
+}
+
 void TurnPoint::setShortName(const std::string &_shortName) {
     shortName = _shortName;
 }
 
+void TurnPoint::setShortName(const char *_shortName) {
+    if (_shortName != NULL)
+        shortName.assign(_shortName);
+    else
+        shortName.clear();
+}
+
 void TurnPoint::setCode(const std::string &_code) {
     code = _code;
 }
 
+void TurnPoint::setCode(const char *_code) {
+    if (_code != NULL)
+        code.assign(_code);
+    else
+        code.clear();
+}
+
 const std::string &TurnPoint::getAnyName() const {
     if (fullName.length() > 0)
         return fullName;
@@ -77,6 +111,12 @@ const std::string &TurnPoint::getAnyName() const {
     return code;
 }
 
+bool TurnPoint::hasName(const std::string &name) const {
+    return strcasecmp(code.c_str(), name.c_str()) == 0 ||
+        strcasecmp(shortName.c_str(), name.c_str()) == 0 ||
+        strcasecmp(fullName.c_str(), name.c_str()) == 0;
+}
+
 const std::string TurnPoint::getAbbreviatedName(std::string::size_type max_length) const {
     /* return fullName if it fits */
     if (fullName.length() > 0 && fullName.length() <= max_length)
@@ -102,6 +142,13 @@ void TurnPoint::setCountry(const std::string &_country) {
     country = _country;
 }
 
+void TurnPoint::setCountry(const char *_country) {
+    if (_country != NULL)
+        country.assign(_country);
+    else
+        country.clear();
+}
+
 void TurnPoint::setPosition(const Position &_position) {
     position = _position;
 }
@@ -110,6 +157,14 @@ void TurnPoint::setType(type_t _type) {
     type = _type;
 }
 
+bool TurnPoint::isAirfield(type_t type) {
+    return type == TYPE_AIRFIELD ||
+        type == TYPE_MILITARY_AIRFIELD ||
+        type == TYPE_GLIDER_SITE ||
+        type == TYPE_ULTRALIGHT_FIELD ||
+        type == TYPE_OUTLANDING;
+}
+
 void TurnPoint::setRunway(const Runway &_runway) {
     runway = _runway;
 }
@@ -121,3 +176,10 @@ void TurnPoint::setFrequency(const Frequency &_frequency) {
 void TurnPoint::setDescription(const std::string &_description) {
     description = _description;
 }
+
+void TurnPoint::setDescription(const char *_description) {
+    if (_description != NULL)
+        description.assign(_description);
+    else
+        description.clear();
+}
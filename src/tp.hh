@@ -91,6 +91,23 @@ public:
         TYPE_MOUNTAIN_WAVE,
         TYPE_THERMALS
     };
+
+    /** bit masks for the attributes, used by Writer::getFields() and
+        Reader::setFields() */
+    enum {
+        FIELD_FULL_NAME = 0x1,
+        FIELD_SHORT_NAME = 0x2,
+        FIELD_CODE = 0x4,
+        FIELD_COUNTRY = 0x8,
+        FIELD_POSITION = 0x10,
+        FIELD_TYPE = 0x20,
+        FIELD_RUNWAY = 0x40,
+        FIELD_FREQUENCY = 0x80,
+        FIELD_DESCRIPTION = 0x100,
+
+        FIELD_NAMES = FIELD_FULL_NAME | FIELD_SHORT_NAME | FIELD_CODE,
+        FIELD_ALL = 0x1ff
+    };
 private:
     std::string fullName, shortName, code, country;
     Position position;
@@ -109,24 +126,41 @@ public:
               const Frequency &_frequency,
               const std::string &_description);
 public:
+    /**
+     * Reset all properties.  Unlike assigning a new object, this
+     * keeps the memory allocated by the strings, so an object can be
+     * reused for reading many turn points.
+     */
+    void clear();
+
     const std::string &getFullName() const {
         return fullName;
     }
     void setFullName(const std::string &_fullName);
+    void setFullName(const char *_fullName);
     const std::string &getShortName() const {
         return shortName;
     }
     void setShortName(const std::string &_shortName);
+    void setShortName(const char *_shortName);
     const std::string &getCode() const {
         return code;
     }
     void setCode(const std::string &_code);
+    void setCode(const char *_code);
     const std::string &getAnyName() const;
+
+    /**
+     * Is the specified string the code, the short name or the full
+     * name of this turn point?  Case is ignored.
+     */
+    bool hasName(const std::string &name) const;
     const std::string getAbbreviatedName(std::string::size_type max_length) const;
     const std::string &getCountry() const {
         return country;
     }
     void setCountry(const std::string &_country);
+    void setCountry(const char *_country);
     const Position &getPosition() const {
         return position;
     }
@@ -135,6 +169,11 @@ public:
         return type;
     }
     void setType(type_t _type);
+
+    /**
+     * Is this type an airfield, or another place where one can land?
+     */
+    static bool isAirfield(type_t type);
     const Runway &getRunway() const {
         return runway;
     }
@@ -147,6 +186,7 @@ public:
         return description;
     }
     void setDescription(const std::string &_description);
+    void setDescription(const char *_description);
 };
 
 #endif
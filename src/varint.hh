@@ -0,0 +1,78 @@
+/*
+ * loggertools
+ * Copyright (C) 2004-2008 Max Kellermann <max@duempel.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; version 2 of the License
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef __LOGGERTOOLS_VARINT_HH
+#define __LOGGERTOOLS_VARINT_HH
+
+#include <stdint.h>
+
+/** the maximum length of a variable length integer */
+static const unsigned VARINT_MAX = 10;
+
+/**
+ * Write an unsigned integer with 7 bits per byte, least significant
+ * group first; the highest bit of each byte says whether another one
+ * follows.  Returns the end of the bytes written.
+ */
+static inline char *
+put_varint(char *p, uint64_t value)
+{
+    while (value >= 0x80) {
+        *p++ = (char)(value | 0x80);
+        value >>= 7;
+    }
+
+    *p++ = (char)value;
+    return p;
+}
+
+/**
+ * Parse a variable length integer.  Returns NULL if the buffer ends
+ * before the integer, or if it is too long.
+ */
+static inline const char *
+get_varint(const char *p, const char *end, uint64_t &value)
+{
+    value = 0;
+
+    for (unsigned shift = 0; shift < 64 && p < end; shift += 7) {
+        const unsigned char ch = (unsigned char)*p++;
+        value |= (uint64_t)(ch & 0x7f) << shift;
+        if ((ch & 0x80) == 0)
+            return p;
+    }
+
+    return NULL;
+}
+
+/** map signed values to unsigned ones, so small negative values get
+    short variable length integers */
+static inline uint64_t
+zigzag(int64_t value)
+{
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static inline int64_t
+unzigzag(uint64_t value)
+{
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+#endif
@@ -0,0 +1,213 @@
+/*
+ * loggertools
+ * Copyright (C) 2004-2008 Max Kellermann <max@duempel.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; version 2 of the License
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+/*
+ * Measures SurfaceCircle::contains() against the exact test
+ * "position - center <= radius" on the turn points of a CUP file:
+ * how many tests the bounding box rejects, and how long both take.
+ * The circles are placed randomly in the bounding box of the turn
+ * points, with radii from 1 m to 9000 km.  Exits with status 1 if
+ * both tests disagree.
+ *
+ * usage: bench-circle FILE.cup NUM_CIRCLES
+ */
+
+#include "tp.hh"
+#include "tp-io.hh"
+#include "earth.hh"
+
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+static double
+now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/** a small deterministic random number generator, so all runs use
+    the same circles */
+static uint32_t random_state = 7;
+
+static uint32_t
+random_next(void)
+{
+    random_state = random_state * 1103515245u + 12345u;
+    return random_state >> 8;
+}
+
+static Angle::value_t
+random_range(Angle::value_t min, Angle::value_t max)
+{
+    return min + (Angle::value_t)(random_next() % (uint32_t)(max - min + 1));
+}
+
+static void
+load(const char *path, std::vector<SurfacePosition> &positions)
+{
+    const SeeYouTurnPointFormat format;
+    TurnPointReader *reader = format.createFileReader(path);
+    std::vector<TurnPoint> buffer(1024);
+    size_t n;
+
+    try {
+        while ((n = reader->read_batch(&buffer[0], buffer.size())) > 0)
+            for (size_t i = 0; i < n; ++i)
+                if (buffer[i].getPosition().defined())
+                    positions.push_back(buffer[i].getPosition());
+    } catch (...) {
+        delete reader;
+        throw;
+    }
+
+    delete reader;
+}
+
+/**
+ * Is the position outside the bounding box of the circle?
+ */
+static bool
+outside_box(const SurfaceCircle &circle, const SurfacePosition &position)
+{
+    const Angle::value_t latitude = position.getLatitude().getValue();
+    const Angle::value_t longitude = position.getLongitude().getValue();
+
+    if (latitude < circle.getMinLatitude() ||
+        latitude > circle.getMaxLatitude())
+        return true;
+
+    if (circle.getMinLongitude() <= circle.getMaxLongitude())
+        return longitude < circle.getMinLongitude() ||
+            longitude > circle.getMaxLongitude();
+
+    /* wraps around at 180 degrees */
+    return longitude < circle.getMinLongitude() &&
+        longitude > circle.getMaxLongitude();
+}
+
+int main(int argc, char **argv) {
+    if (argc != 3) {
+        fprintf(stderr, "usage: bench-circle FILE.cup NUM_CIRCLES\n");
+        return 1;
+    }
+
+    std::vector<SurfacePosition> positions;
+    try {
+        load(argv[1], positions);
+    } catch (const std::exception &e) {
+        fprintf(stderr, "%s\n", e.what());
+        return 2;
+    }
+
+    if (positions.empty()) {
+        fprintf(stderr, "No turn points with a position\n");
+        return 2;
+    }
+
+    Angle::value_t min_latitude = positions[0].getLatitude().getValue();
+    Angle::value_t max_latitude = min_latitude;
+    Angle::value_t min_longitude = positions[0].getLongitude().getValue();
+    Angle::value_t max_longitude = min_longitude;
+
+    for (std::vector<SurfacePosition>::const_iterator it = positions.begin();
+         it != positions.end(); ++it) {
+        const Angle::value_t latitude = it->getLatitude().getValue();
+        const Angle::value_t longitude = it->getLongitude().getValue();
+
+        if (latitude < min_latitude)
+            min_latitude = latitude;
+        if (latitude > max_latitude)
+            max_latitude = latitude;
+        if (longitude < min_longitude)
+            min_longitude = longitude;
+        if (longitude > max_longitude)
+            max_longitude = longitude;
+    }
+
+    static const double radii[] = {
+        1, 100, 5000, 50000, 200000, 500000, 2000000, 9000000,
+    };
+
+    const unsigned num_circles = (unsigned)atoi(argv[2]);
+    std::vector<SurfaceCircle> circles;
+    for (unsigned i = 0; i < num_circles; ++i) {
+        const SurfacePosition center(Latitude(random_range(min_latitude,
+                                                           max_latitude)),
+                                     Longitude(random_range(min_longitude,
+                                                            max_longitude)));
+        const double factor = 0.5 + (random_next() % 1000) / 1000.;
+        circles.push_back(SurfaceCircle(center,
+                                        Distance(Distance::UNIT_METERS,
+                                                 radii[i % 8] * factor)));
+    }
+
+    /* the exact test */
+    std::vector<unsigned char> expected;
+    expected.reserve(circles.size() * positions.size());
+
+    double start = now();
+    for (std::vector<SurfaceCircle>::const_iterator c = circles.begin();
+         c != circles.end(); ++c)
+        for (std::vector<SurfacePosition>::const_iterator p = positions.begin();
+             p != positions.end(); ++p)
+            expected.push_back(*p - c->getCenter() <= c->getRadius());
+    const double exact_time = now() - start;
+
+    /* with the bounding box */
+    std::vector<unsigned char> result;
+    result.reserve(expected.size());
+
+    start = now();
+    for (std::vector<SurfaceCircle>::const_iterator c = circles.begin();
+         c != circles.end(); ++c)
+        for (std::vector<SurfacePosition>::const_iterator p = positions.begin();
+             p != positions.end(); ++p)
+            result.push_back(c->contains(*p));
+    const double circle_time = now() - start;
+
+    unsigned long rejected = 0, inside = 0, mismatches = 0;
+    size_t k = 0;
+    for (std::vector<SurfaceCircle>::const_iterator c = circles.begin();
+         c != circles.end(); ++c) {
+        for (std::vector<SurfacePosition>::const_iterator p = positions.begin();
+             p != positions.end(); ++p, ++k) {
+            if (c->isBounded() && outside_box(*c, *p))
+                ++rejected;
+            inside += expected[k];
+            if (result[k] != expected[k])
+                ++mismatches;
+        }
+    }
+
+    printf("%u circles, %u positions, %lu inside\n",
+           (unsigned)circles.size(), (unsigned)positions.size(), inside);
+    printf("box rejects %.1f%% of the tests\n",
+           100. * rejected / expected.size());
+    printf("exact only %.3f s, with SurfaceCircle %.3f s\n",
+           exact_time, circle_time);
+    printf("%lu mismatches\n", mismatches);
+
+    return mismatches > 0 ? 1 : 0;
+}
@@ -0,0 +1,94 @@
+#!/usr/bin/env python3
+#
+#  loggertools
+#  Copyright (C) 2004-2008 Max Kellermann <max@duempel.org>
+#
+#  This program is free software; you can redistribute it and/or
+#  modify it under the terms of the GNU General Public License as
+#  published by the Free Software Foundation; version 2 of the License
+#
+#  This program is distributed in the hope that it will be useful, but
+#  WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+#  General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software
+#  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+#  02111-1307, USA.
+#
+
+#
+# Measures the CPU time (user + system, best of several runs) of
+# tpconv, see "make bench".
+#
+# usage: bench-tpconv.py TPCONV seeyou FILE.cup
+#        bench-tpconv.py TPCONV tpb FILE.cup
+#
+# "seeyou" only parses the CUP file (no turn point matches the
+# filter, so nothing is written).  "tpb" converts the file to tpb,
+# and compares reading and writing both formats.
+#
+
+import os
+import sys
+
+RUNS = 7
+
+def cpu_time(args):
+    """Run the command (with stdout discarded), and return its CPU
+    time in seconds."""
+    pid = os.fork()
+    if pid == 0:
+        fd = os.open('/dev/null', os.O_WRONLY)
+        os.dup2(fd, 1)
+        os.execv(args[0], args)
+        os._exit(127)
+
+    _, status, usage = os.wait4(pid, 0)
+    if not os.WIFEXITED(status) or os.WEXITSTATUS(status) != 0:
+        sys.stderr.write('failed: %s\n' % ' '.join(args))
+        sys.exit(2)
+
+    return usage.ru_utime + usage.ru_stime
+
+def best(args):
+    return min([cpu_time(args) for i in range(RUNS)])
+
+def bench_seeyou(tpconv, path):
+    output = os.path.splitext(path)[0] + '-bench.cup'
+    print('%s: parse only (-F name:nomatch), best of %d: %.3f s' %
+          (path, RUNS, best([tpconv, '-F', 'name:nomatch', path,
+                             '-o', output])))
+
+def bench_tpb(tpconv, path):
+    base = os.path.splitext(path)[0]
+    tpb = base + '.tpb'
+    cpu_time([tpconv, path, '-o', tpb])
+
+    print('%s, best of %d runs:' % (path, RUNS))
+    print('%-20s %10s %10s' % ('', 'CUP', 'tpb'))
+    print('%-20s %9.2fM %9.2fM' % ('file size',
+                                   os.path.getsize(path) / 1e6,
+                                   os.path.getsize(tpb) / 1e6))
+
+    tests = (
+        ('read only', ['-F', 'name:nomatch'], '-bench.cup'),
+        ('read, airfield', ['-F', 'airfield'], '-bench.cup'),
+        ('read, write CUP', [], '-bench.cup'),
+        ('read, write tpb', [], '-bench.tpb'),
+    )
+
+    for name, args, suffix in tests:
+        times = [best([tpconv] + args + [input, '-o', base + suffix])
+                 for input in (path, tpb)]
+        print('%-20s %9.3fs %9.3fs' % (name, times[0], times[1]))
+
+if len(sys.argv) != 4 or sys.argv[2] not in ('seeyou', 'tpb'):
+    sys.stderr.write('usage: bench-tpconv.py TPCONV seeyou|tpb FILE.cup\n')
+    sys.exit(1)
+
+if sys.argv[2] == 'seeyou':
+    bench_seeyou(sys.argv[1], sys.argv[3])
+else:
+    bench_tpb(sys.argv[1], sys.argv[3])
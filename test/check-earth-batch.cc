@@ -0,0 +1,239 @@
+/*
+ * loggertools
+ * Copyright (C) 2004-2008 Max Kellermann <max@duempel.org>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; version 2 of the License
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+/*
+ * Compares PositionBatch::distances() and PositionBatch::within()
+ * with operator-() on random pairs of positions, including the
+ * poles, the date line, antipodes and undefined positions.  The
+ * output ends with a hash of all results; "make check" builds this
+ * program with the scalar, the SSE2 and the AVX code, and compares
+ * their output.
+ */
+
+#include "earth.hh"
+#include "earth-batch.hh"
+
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdint.h>
+
+/** the number of positions in the batch */
+static const unsigned NUM_POSITIONS = 4000;
+
+/** the number of reference points */
+static const unsigned NUM_REFERENCES = 250;
+
+/** the maximum deviation of distances() from operator-() in meters */
+static const double MAX_DEVIATION = 1e-3;
+
+static const Angle::value_t MAX_LATITUDE = 90 * 60 * 1000;
+static const Angle::value_t MAX_LONGITUDE = 180 * 60 * 1000;
+
+/** a small deterministic random number generator, so all builds
+    check the same positions */
+static uint32_t random_state = 1;
+
+static uint32_t
+random_next(void)
+{
+    random_state = random_state * 1103515245u + 12345u;
+    return random_state >> 8;
+}
+
+static Angle::value_t
+random_range(Angle::value_t min, Angle::value_t max)
+{
+    return min + (Angle::value_t)(random_next() % (uint32_t)(max - min + 1));
+}
+
+/**
+ * A random position; some of them are on or near a pole or the date
+ * line, or are undefined.
+ */
+static SurfacePosition
+random_position(void)
+{
+    Angle::value_t latitude = random_range(-MAX_LATITUDE, MAX_LATITUDE);
+    Angle::value_t longitude = random_range(-MAX_LONGITUDE, MAX_LONGITUDE);
+
+    switch (random_next() % 16) {
+    case 0:
+        latitude = random_next() % 2 ? MAX_LATITUDE : -MAX_LATITUDE;
+        break;
+
+    case 1:
+        latitude = (random_next() % 2 ? MAX_LATITUDE : -MAX_LATITUDE)
+            - random_range(-1000, 1000);
+        if (latitude > MAX_LATITUDE)
+            latitude = MAX_LATITUDE;
+        else if (latitude < -MAX_LATITUDE)
+            latitude = -MAX_LATITUDE;
+        break;
+
+    case 2:
+        longitude = random_next() % 2 ? MAX_LONGITUDE : -MAX_LONGITUDE;
+        break;
+
+    case 3:
+        longitude = MAX_LONGITUDE - random_range(0, 2000);
+        if (random_next() % 2)
+            longitude = -longitude;
+        break;
+
+    case 4:
+        return SurfacePosition();
+    }
+
+    return SurfacePosition(Latitude(latitude), Longitude(longitude));
+}
+
+/**
+ * A position near "p", or its antipode.
+ */
+static SurfacePosition
+near_position(const SurfacePosition &p, bool antipode)
+{
+    Angle::value_t latitude = p.getLatitude().getValue();
+    Angle::value_t longitude = p.getLongitude().getValue();
+
+    if (antipode) {
+        latitude = -latitude;
+        longitude += longitude > 0 ? -MAX_LONGITUDE : MAX_LONGITUDE;
+    }
+
+    latitude += random_range(-3000, 3000);
+    longitude += random_range(-3000, 3000);
+
+    if (latitude > MAX_LATITUDE)
+        latitude = MAX_LATITUDE;
+    else if (latitude < -MAX_LATITUDE)
+        latitude = -MAX_LATITUDE;
+
+    if (longitude > MAX_LONGITUDE)
+        longitude -= 2 * MAX_LONGITUDE;
+    else if (longitude < -MAX_LONGITUDE)
+        longitude += 2 * MAX_LONGITUDE;
+
+    return SurfacePosition(Latitude(latitude), Longitude(longitude));
+}
+
+static uint64_t
+hash_bytes(uint64_t hash, const void *data, size_t length)
+{
+    const unsigned char *p = (const unsigned char*)data;
+
+    for (size_t i = 0; i < length; ++i)
+        hash = (hash ^ p[i]) * 1099511628211ull;
+
+    return hash;
+}
+
+int main(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+
+    std::vector<SurfacePosition> references;
+    PositionBatch batch;
+
+    for (unsigned i = 0; i < NUM_REFERENCES; ++i)
+        references.push_back(random_position());
+
+    /* a part of the positions is near a reference or its antipode,
+       where the formulas are least accurate */
+    for (unsigned i = 0; i < NUM_POSITIONS; ++i) {
+        const SurfacePosition &reference =
+            references[random_next() % references.size()];
+
+        if (i % 4 == 0 && reference.defined())
+            batch.append(near_position(reference, i % 8 == 0));
+        else
+            batch.append(random_position());
+    }
+
+    std::vector<double> distances(batch.size());
+    std::vector<unsigned char> within(batch.size());
+    uint64_t hash = 14695981039346656037ull;
+    double max_deviation = 0.;
+    unsigned long pairs = 0, inside = 0, errors = 0;
+
+    for (std::vector<SurfacePosition>::const_iterator it = references.begin();
+         it != references.end(); ++it) {
+        const SurfacePosition &reference = *it;
+
+        batch.distances(reference, 0, batch.size(), &distances[0]);
+
+        for (size_t i = 0; i < batch.size(); ++i) {
+            const double expected = (batch[i] - reference).getMeters();
+            double deviation = fabs(distances[i] - expected);
+            if (isnan(expected) || isnan(distances[i]))
+                deviation = isnan(expected) == isnan(distances[i])
+                    ? 0. : HUGE_VAL;
+
+            if (!(deviation <= MAX_DEVIATION)) {
+                if (errors++ < 10)
+                    fprintf(stderr, "distances() deviates by %g m at %u\n",
+                            deviation, (unsigned)i);
+            } else if (deviation > max_deviation)
+                max_deviation = deviation;
+        }
+
+        hash = hash_bytes(hash, &distances[0],
+                          distances.size() * sizeof(distances[0]));
+
+        /* radii from 1 km to the whole earth; a part of them is the
+           distance of a position, i.e. exactly on the border */
+        for (unsigned j = 0; j < 4; ++j) {
+            const size_t k = random_next() % batch.size();
+            const Distance radius(Distance::UNIT_METERS, j == 0
+                                  ? (batch[k] - reference).getMeters()
+                                  : 1000. * (1 + random_next() % 20000));
+
+            batch.within(reference, radius, 0, batch.size(), &within[0]);
+
+            for (size_t i = 0; i < batch.size(); ++i) {
+                const bool expected = batch[i] - reference <= radius;
+                if (within[i] != (unsigned char)expected &&
+                    errors++ < 10)
+                    fprintf(stderr, "within() differs at %u\n",
+                            (unsigned)i);
+
+                inside += within[i];
+                ++pairs;
+            }
+
+            hash = hash_bytes(hash, &within[0], within.size());
+        }
+    }
+
+    printf("distances: %lu pairs, max deviation %.3g m\n",
+           (unsigned long)(references.size() * batch.size()), max_deviation);
+    printf("within: %lu pairs, %lu inside\n", pairs, inside);
+    printf("hash: %016llx\n", (unsigned long long)hash);
+
+    if (errors > 0) {
+        fprintf(stderr, "%lu errors\n", errors);
+        return 1;
+    }
+
+    return 0;
+}
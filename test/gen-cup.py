@@ -0,0 +1,95 @@
+#!/usr/bin/env python3
+#
+#  loggertools
+#  Copyright (C) 2004-2008 Max Kellermann <max@duempel.org>
+#
+#  This program is free software; you can redistribute it and/or
+#  modify it under the terms of the GNU General Public License as
+#  published by the Free Software Foundation; version 2 of the License
+#
+#  This program is distributed in the hope that it will be useful, but
+#  WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+#  General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software
+#  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+#  02111-1307, USA.
+#
+
+#
+# Generates a SeeYou (CUP) file with random turn points for the
+# checks and benchmarks, see "make check" and "make bench".
+#
+# usage: gen-cup.py [--world] [--seed N] COUNT
+#
+# By default, the turn points are in Central Europe (35..60N,
+# 8W..25E); with --world, they are spread over the whole earth,
+# including the poles and the date line.
+#
+
+import random
+import sys
+
+def format_angle(value, digits, positive, negative):
+    letter = positive if value >= 0 else negative
+    value = abs(value)
+    degrees = int(value)
+    minutes = (value - degrees) * 60
+    return '%0*d%06.3f%s' % (digits, degrees, minutes, letter)
+
+def main(args):
+    world = False
+    seed = 1
+    while len(args) > 1 and args[0].startswith('--'):
+        if args[0] == '--world':
+            world = True
+            args = args[1:]
+        elif args[0] == '--seed':
+            seed = int(args[1])
+            args = args[2:]
+        else:
+            break
+
+    if len(args) != 1:
+        sys.stderr.write('usage: gen-cup.py [--world] [--seed N] COUNT\n')
+        sys.exit(1)
+
+    count = int(args[0])
+    rnd = random.Random(seed)
+    countries = ['DE', 'FR', 'AT', 'CH', 'IT', 'PL', 'CZ']
+    out = sys.stdout
+
+    out.write('name,code,country,lat,lon,elev,style,rwdir,rwlen,freq,desc\r\n')
+    for i in range(count):
+        if world:
+            latitude = rnd.uniform(-90, 90)
+            longitude = rnd.uniform(-180, 180)
+            if i % 50 == 0:
+                latitude = rnd.choice([-89.99, 89.99])
+            elif i % 50 == 1:
+                longitude = rnd.choice([-179.99, 179.99])
+        else:
+            latitude = rnd.uniform(35, 60)
+            longitude = rnd.uniform(-8, 25)
+
+        style = rnd.choice([1, 1, 1, 2, 3, 4, 5, 6, 7, 17])
+        if rnd.random() < 0.5:
+            description = '"desc %d %s"' % (i, 'x' * rnd.randint(0, 40))
+        else:
+            description = ''
+
+        out.write('"TP %d","T%05d",%s,%s,%s,%dm,%d,%s,%s,%s,%s\r\n' %
+                  (i, i % 100000, rnd.choice(countries),
+                   format_angle(latitude, 2, 'N', 'S'),
+                   format_angle(longitude, 3, 'E', 'W'),
+                   rnd.randint(0, 3000), style,
+                   rnd.choice(['', '090', '270', '180']),
+                   rnd.choice(['', '800', '1200']),
+                   rnd.choice(['', '123.500', '122.475']),
+                   description))
+
+    out.write('-----Related Tasks-----\r\n')
+
+main(sys.argv[1:])